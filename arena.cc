@@ -0,0 +1,125 @@
+/* File: arena.cc
+ * --------------
+ * Implementation of arenas.
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include "utility.h"
+
+static const size_t ChunkSize = 256 << 10;       // standard chunk, header included
+static const size_t Alignment = alignof(max_align_t);
+static const int MaxFreeChunks = 64;             // kept per thread for reuse
+
+// standard-size chunks released by earlier arenas on this thread
+static thread_local void *freeChunks[MaxFreeChunks];
+static thread_local int numFreeChunks;
+
+static inline size_t RoundUp(size_t n) { return (n + Alignment - 1) & ~(Alignment - 1); }
+
+
+Arena::Arena() {
+    chunks = NULL;
+    next = limit = NULL;
+    bytesAllocated = 0;
+    stringBytes = 0;
+}
+
+Arena::~Arena() {
+    Release();
+}
+
+void *Arena::Allocate(size_t size) {
+    size = RoundUp(size);
+    bytesAllocated += size;
+    if (size > (size_t)(limit - next))
+        return AllocateInNewChunk(size);
+    void *result = next;
+    next += size;
+    return result;
+}
+
+/* Function: AllocateInNewChunk
+ * ----------------------------
+ * Starts a new standard chunk, or gives a request too big for one a
+ * chunk of its own. An oversized chunk goes behind the current one so
+ * the space left in the current chunk is not wasted.
+ */
+void *Arena::AllocateInNewChunk(size_t size) {
+    size_t header = RoundUp(sizeof(Chunk));
+    if (header + size > ChunkSize / 2) {
+        Chunk *big = (Chunk *)malloc(header + size);
+        if (!big) Failure("Out of memory");
+        big->size = header + size;
+        if (chunks) {
+            big->next = chunks->next;
+            chunks->next = big;
+        } else {
+            big->next = NULL;
+            chunks = big;
+        }
+        return (char *)big + header;
+    }
+    Chunk *chunk = (Chunk *)(numFreeChunks > 0 ? freeChunks[--numFreeChunks] : malloc(ChunkSize));
+    if (!chunk) Failure("Out of memory");
+    chunk->size = ChunkSize;
+    chunk->next = chunks;
+    chunks = chunk;
+    next = (char *)chunk + header + size;
+    limit = (char *)chunk + ChunkSize;
+    return (char *)chunk + header;
+}
+
+char *Arena::Strdup(const char *s) {
+    size_t length = strlen(s) + 1;
+    stringBytes += length;
+    return (char *)memcpy(Allocate(length), s, length);
+}
+
+void Arena::OnRelease(void (*cleanup)(void *), void *object) {
+    Cleanup c = { cleanup, object };
+    cleanups.push_back(c);
+}
+
+/* Function: Owns
+ * --------------
+ * Searches the chunks, newest first, so is only for occasional use (a
+ * list asks when it first spills out of its inline room).
+ */
+bool Arena::Owns(const void *p) {
+    for (Chunk *chunk = chunks; chunk; chunk = chunk->next)
+        if (p >= (void *)chunk && p < (void *)((char *)chunk + chunk->size))
+            return true;
+    return false;
+}
+
+void Arena::Release() {
+    for (size_t i = cleanups.size(); i > 0; i--)
+        cleanups[i-1].cleanup(cleanups[i-1].object);
+    cleanups.clear();
+    while (chunks) {
+        Chunk *chunk = chunks;
+        chunks = chunk->next;
+        if (chunk->size == ChunkSize && numFreeChunks < MaxFreeChunks)
+            freeChunks[numFreeChunks++] = chunk;
+        else
+            free(chunk);
+    }
+    next = limit = NULL;
+    bytesAllocated = 0;
+    stringBytes = 0;
+}
+
+void *AllocateInCurrentArena(size_t size, void (*cleanup)(void *)) {
+    Arena *arena = CurrentArena();
+    if (!arena) return ::operator new(size);
+    void *object = arena->Allocate(size);
+    if (cleanup) arena->OnRelease(cleanup, object);
+    return object;
+}
+
+char *StrdupInCurrentArena(const char *s) {
+    Arena *arena = CurrentArena();
+    return arena ? arena->Strdup(s) : strdup(s);
+}
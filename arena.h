@@ -0,0 +1,73 @@
+/* File: arena.h
+ * -------------
+ * An Arena hands out memory by bumping a pointer through large chunks
+ * and gives it all back at once when it is released. Each compilation
+ * has one, and the AST nodes, lists and names made while it is current
+ * are allocated from it, so a translation unit's tree is laid out close
+ * together and is freed in one go when the unit is done.
+ *
+ * Most objects are only bump allocations, dropped with their chunk. The
+ * few that come to own memory elsewhere (a node's scope table, the
+ * storage of a list that outgrew its inline room) register a cleanup
+ * that runs when the arena is released, in the reverse of the order
+ * they were registered. Released chunks of the standard size are kept
+ * on a per-thread free list and reused by the next arena, so a
+ * long-running process reaches a steady state instead of going back to
+ * malloc for every unit.
+ */
+
+#ifndef _H_arena
+#define _H_arena
+
+#include <stddef.h>
+#include <vector>
+
+
+class Arena
+{
+  public:
+    Arena();
+    ~Arena();     // releases everything
+
+        // Memory aligned for any type, valid until the arena is released
+    void *Allocate(size_t size);
+    char *Strdup(const char *s);
+
+        // Calls cleanup(object) when the arena is released
+    void OnRelease(void (*cleanup)(void *), void *object);
+
+        // Whether p points into memory allocated from the arena
+    bool Owns(const void *p);
+
+        // Runs the cleanups and gives back all the memory
+    void Release();
+
+    size_t BytesAllocated()  { return bytesAllocated; }
+    size_t StringBytes()     { return stringBytes; }   // by Strdup
+
+  private:
+    struct Chunk { Chunk *next; size_t size; };
+    struct Cleanup { void (*cleanup)(void *); void *object; };
+
+    Chunk *chunks;                   // most recent first
+    char *next, *limit;              // free space in the current chunk
+    size_t bytesAllocated;
+    size_t stringBytes;
+    std::vector<Cleanup> cleanups;
+
+    void *AllocateInNewChunk(size_t size);
+};
+
+
+/* Functions: CurrentArena and friends
+ * -----------------------------------
+ * The arena of the current compilation (defined in compilation.cc), and
+ * shorthands for allocating from it. When no compilation is current, as
+ * for the built-in types made at startup, memory comes from the heap and
+ * is never freed.
+ */
+Arena *CurrentArena();
+void *AllocateInCurrentArena(size_t size, void (*cleanup)(void *));
+char *StrdupInCurrentArena(const char *s);
+
+#endif
@@ -5,36 +5,128 @@
 #include "ast.h"
 #include "ast_type.h"
 #include "ast_decl.h"
+#include "ast_expr.h"
+#include "ast_stmt.h"
 #include "errors.h"
-#include <string.h> // strdup
+#include "compilation.h"
+#include "stats.h"
+#include "arena.h"
 #include <stdio.h>  // printf
 
-Node::Node(yyltype loc) {
-    location = new yyltype(loc);
+static const struct { const char *name; size_t size; } nodeClasses[] = {
+    { "Program", sizeof(Program) }, { "Identifier", sizeof(Identifier) },
+    { "Error", sizeof(Error) }, { "Operator", sizeof(Operator) },
+    { "VarDecl", sizeof(VarDecl) }, { "FnDecl", sizeof(FnDecl) },
+    { "ClassDecl", sizeof(ClassDecl) }, { "InterfaceDecl", sizeof(InterfaceDecl) },
+    { "Type", sizeof(Type) }, { "NamedType", sizeof(NamedType) },
+    { "ArrayType", sizeof(ArrayType) },
+    { "StmtBlock", sizeof(StmtBlock) }, { "ForStmt", sizeof(ForStmt) },
+    { "WhileStmt", sizeof(WhileStmt) }, { "IfStmt", sizeof(IfStmt) },
+    { "BreakStmt", sizeof(BreakStmt) }, { "ReturnStmt", sizeof(ReturnStmt) },
+    { "PrintStmt", sizeof(PrintStmt) },
+    { "EmptyExpr", sizeof(EmptyExpr) }, { "IntConstant", sizeof(IntConstant) },
+    { "DoubleConstant", sizeof(DoubleConstant) }, { "BoolConstant", sizeof(BoolConstant) },
+    { "StringConstant", sizeof(StringConstant) }, { "NullConstant", sizeof(NullConstant) },
+    { "ArithmeticExpr", sizeof(ArithmeticExpr) }, { "RelationalExpr", sizeof(RelationalExpr) },
+    { "EqualityExpr", sizeof(EqualityExpr) }, { "LogicalExpr", sizeof(LogicalExpr) },
+    { "AssignExpr", sizeof(AssignExpr) },
+    { "ArrayAccess", sizeof(ArrayAccess) }, { "FieldAccess", sizeof(FieldAccess) },
+    { "This", sizeof(This) }, { "Call", sizeof(Call) },
+    { "NewExpr", sizeof(NewExpr) }, { "NewArrayExpr", sizeof(NewArrayExpr) },
+    { "ReadIntegerExpr", sizeof(ReadIntegerExpr) }, { "ReadLineExpr", sizeof(ReadLineExpr) },
+};
+static_assert(sizeof(nodeClasses) / sizeof(nodeClasses[0]) == NumNodeKinds,
+              "nodeClasses needs one entry per NodeKind, in order");
+static_assert(NumNodeKinds <= MaxNodeKinds, "UnitStats counts too few kinds");
+
+const char *NodeKindName(NodeKind kind)  { return nodeClasses[kind].name; }
+size_t NodeKindSize(NodeKind kind)       { return nodeClasses[kind].size; }
+
+// The nodes that open a scope, which are also the only ones holding
+// memory outside the arena (their tables)
+static inline bool OpensScope(NodeKind kind) {
+    switch (kind) {
+      case KindProgram: case KindClassDecl: case KindInterfaceDecl:
+      case KindFnDecl: case KindStmtBlock:
+        return true;
+      default:
+        return false;
+    }
+}
+
+// Runs the destructor of a node when its arena is released. Every node
+// class derives from Node alone, so the node starts at its Node part.
+static void DestroyNode(void *node) {
+    ((Node *)node)->~Node();
+}
+
+// Keeps the nodes that open a scope, so their scopes can be filled
+// before names are bound and measured for --mem-report. Those nodes are
+// also destroyed when the arena they were allocated from (the current
+// one, see operator new) is released, to free their tables; any other
+// node is just dropped with the arena. Counts the allocation for
+// --time-report and --mem-report too. The built-in types are made
+// before there is any compilation.
+static inline void RegisterNode(Node *node) {
+    Compilation *unit = Compilation::Current();
+    if (!unit) return;
+    if (OpensScope(node->kind)) {
+        unit->arena->OnRelease(DestroyNode, node);
+        unit->scopeNodes.push_back(node);
+    }
+    if (!unit->stats) return;
+    unit->stats->numNodes++;
+    unit->stats->nodeCounts[node->kind]++;
+}
+
+void *Node::operator new(size_t size) {
+    return AllocateInCurrentArena(size, NULL);
+}
+
+Node::Node(NodeKind k, yyltype loc) : kind(k) {
+    location = loc;
     parent = NULL;
+    RegisterNode(this);
 }
 
-Node::Node() {
-    location = NULL;
+Node::Node(NodeKind k) : kind(k) {
+    location.offset = NoLocation;
+    location.length = 0;
     parent = NULL;
+    RegisterNode(this);
 }
 
-Decl* Node::FindDecl(std::string id_name) {
+Decl* Node::FindDecl(Symbol id_name) {
     Node *current = this;
-    // Look for parent
+    UnitStats *stats = Compilation::Current()->stats;
+    if (stats) stats->numLookups++;
+    // Look for parent, skipping nodes that don't open a scope
     while (current != NULL) {
-      if (current->scope.find(id_name) != current->scope.end()){
-        return current->scope[id_name];
+      Scope *scope = current->GetScope();
+      if (scope) {
+        if (stats) stats->numScopesProbed++;
+        Scope::iterator found = scope->find(id_name);
+        if (found != scope->end())
+          return found->second;
       }
       current = current->parent;
     }
     return NULL;
 }
 
+// Looks in this node's own scope only, NULL if it has none
+Decl* Node::FindLocalDecl(Symbol id_name) {
+    Scope *scope = GetScope();
+    if (!scope) return NULL;
+    Scope::iterator found = scope->find(id_name);
+    return found == scope->end() ? NULL : found->second;
+}
+
 void Node::InitScope(List<Decl*> *decl_list) {
+    Scope &scope = *GetScope();
     for (int i = 0; i < decl_list->NumElements(); ++i){
       Decl* currentDecl = decl_list->Nth(i);
-      const char* name = currentDecl->id->name;
+      Symbol name = currentDecl->id->symbol;
       // report if this decl already exists yo
       if (scope.find(name) != scope.end()){
         Decl* oldDecl = scope[name];
@@ -45,7 +137,8 @@ void Node::InitScope(List<Decl*> *decl_list) {
     }
 }
 	 
-Identifier::Identifier(yyltype loc, const char *n) : Node(loc) {
-    name = strdup(n);
+Identifier::Identifier(yyltype loc, Symbol s) : Node(KindIdentifier, loc) {
+    symbol = s;
+    name = Compilation::Current()->symbols->Name(s);
 } 
 
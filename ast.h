@@ -6,10 +6,11 @@
  * more correctly, of instances of concrete subclassses such as VarDecl,
  * ForStmt, and AssignExpr).
  * 
- * Location: Each node maintains its lexical location (line and columns in 
- * file), that location can be NULL for those nodes that don't care/use 
- * locations. The location is typcially set by the node constructor.  The 
- * location is used to provide the context when reporting semantic errors.
+ * Location: Each node maintains its lexical location (the range of bytes
+ * it covers in the file, stored in the node itself), that location can be
+ * NULL for those nodes that don't care/use locations. The location is
+ * typcially set by the node constructor.  The location is used to provide
+ * the context when reporting semantic errors.
  *
  * Parent: Each node has a pointer to its parent. For a Program node, the 
  * parent is NULL, for all other nodes it is the pointer to the node one level
@@ -19,6 +20,11 @@
  * set up links in both directions. The parent link is typically not used 
  * during parsing, but is more important in later phases.
  *
+ * Kind: Each node also records which concrete class it is, so the checker
+ * can test a node's class with a compare instead of a dynamic_cast. Use
+ * isa<T>(n), cast<T>(n) and dyn_cast<T>(n) below; every class provides a
+ * static classof saying which kinds belong to it.
+ *
  * Semantic analysis: For pp3 you are adding "Check" behavior to the ast
  * node classes. Your semantic analyzer should do an inorder walk on the
  * parse tree, and when visiting each node, verify the particular
@@ -32,39 +38,127 @@
 #include <stdlib.h>   // for NULL
 #include "location.h"
 #include "list.h"
+#include "utility.h"
+#include "symtab.h"
 #include <unordered_map>
 #include "hashtable.h"
 #include <string>
 #include <iostream>
 class Decl;
 
+typedef std::unordered_map<Symbol, Decl*> Scope;
+
+/* Enum: NodeKind
+ * --------------
+ * One value per concrete node class. The subclasses of each abstract
+ * class are listed together, so membership in the abstract class is a
+ * range check against its First/Last markers.
+ */
+enum NodeKind {
+    KindProgram, KindIdentifier, KindError, KindOperator,
+
+    KindVarDecl, KindFnDecl, KindClassDecl, KindInterfaceDecl,
+    FirstDecl = KindVarDecl, LastDecl = KindInterfaceDecl,
+
+    KindBuiltinType, KindNamedType, KindArrayType,
+    FirstType = KindBuiltinType, LastType = KindArrayType,
+
+    KindStmtBlock, KindForStmt, KindWhileStmt, KindIfStmt,
+    KindBreakStmt, KindReturnStmt, KindPrintStmt,
+
+    KindEmptyExpr, KindIntConstant, KindDoubleConstant, KindBoolConstant,
+    KindStringConstant, KindNullConstant,
+    KindArithmeticExpr, KindRelationalExpr, KindEqualityExpr,
+    KindLogicalExpr, KindAssignExpr,
+    KindArrayAccess, KindFieldAccess,
+    KindThis, KindCall, KindNewExpr, KindNewArrayExpr,
+    KindReadIntegerExpr, KindReadLineExpr,
+
+    FirstStmt = KindStmtBlock, LastStmt = KindReadLineExpr,
+    FirstConditionalStmt = KindForStmt, LastConditionalStmt = KindIfStmt,
+    FirstLoopStmt = KindForStmt, LastLoopStmt = KindWhileStmt,
+    FirstExpr = KindEmptyExpr, LastExpr = KindReadLineExpr,
+    FirstCompoundExpr = KindArithmeticExpr, LastCompoundExpr = KindAssignExpr,
+    FirstLValue = KindArrayAccess, LastLValue = KindFieldAccess,
+
+    NumNodeKinds = KindReadLineExpr + 1
+};
+
+    // The name and size of the class of each kind, for --mem-report
+const char *NodeKindName(NodeKind kind);
+size_t NodeKindSize(NodeKind kind);
+
 class Node 
 {
   public:
-    yyltype *location;
+    yyltype location;        // offset is NoLocation if the node has none
     Node *parent;
-    std::unordered_map<std::string, Decl*> scope;
+    const NodeKind kind;
 
   public:
-    Node(yyltype loc);
-    Node();
-    
-    yyltype *GetLocation()   { return location; }
+    Node(NodeKind kind, yyltype loc);
+    Node(NodeKind kind);
+    virtual ~Node() {}
+
+        // Nodes live in the current compilation's arena and are destroyed
+        // when it is released, never one by one (see arena.h)
+    static void *operator new(size_t size);
+    static void operator delete(void *) {}
+
+    static const unsigned int NoLocation = ~0u;
+
+    yyltype *GetLocation()   { return location.offset == NoLocation ? NULL : &location; }
     void SetParent(Node *p)  { parent = p; }
     Node *GetParent()        { return parent; }
-    Decl* FindDecl(std::string id_name);
+    Decl* FindDecl(Symbol id_name);
+    Decl* FindLocalDecl(Symbol id_name);
     void InitScope(List<Decl*> *decl_list);
+
+        // Only the nodes that open a scope (the program, classes,
+        // interfaces, functions and blocks) have a table of the names
+        // declared in it; everything else returns NULL
+    virtual Scope *GetScope() { return NULL; }
     virtual void Check()     { ; }
+
+        // Fills the scope of a function or block with its parameters or
+        // variables, first of each name winning, without reporting the
+        // rest; Check does that. Program::Check calls it on every node
+        // owning a scope before any names are bound.
+    virtual void DeclareLocals() { ; }
 };
+
+
+/* Function: isa, cast, dyn_cast
+ * -----------------------------
+ * Class tests on nodes by kind. isa<T>(n) says whether n is a T, cast<T>
+ * converts a node known to be a T (asserting that it is), and dyn_cast<T>
+ * converts n if it is a T and gives NULL otherwise. Unlike isa and cast,
+ * dyn_cast accepts a NULL node, since most of its arguments come straight
+ * from a lookup that may have found nothing.
+ */
+template <class T> inline bool isa(Node *n) {
+    return T::classof(n);
+}
+
+template <class T> inline T *cast(Node *n) {
+    Assert(n != NULL && T::classof(n));
+    return static_cast<T *>(n);
+}
+
+template <class T> inline T *dyn_cast(Node *n) {
+    return n != NULL && T::classof(n) ? static_cast<T *>(n) : NULL;
+}
    
 
 class Identifier : public Node 
 {
   public:
-    char *name;
+    Symbol symbol;
+    const char *name;        // the symbol's text, for messages
     
   public:
-    Identifier(yyltype loc, const char *name);
+    Identifier(yyltype loc, Symbol symbol);
+    static bool classof(Node *n) { return n->kind == KindIdentifier; }
     friend std::ostream& operator<<(std::ostream& out, Identifier *id) { return out << id->name; }
 };
 
@@ -77,7 +171,8 @@ class Identifier : public Node
 class Error : public Node
 {
   public:
-    Error() : Node() {}
+    Error() : Node(KindError) {}
+    static bool classof(Node *n) { return n->kind == KindError; }
 };
 
 
@@ -6,22 +6,20 @@
 #include "ast_type.h"
 #include "ast_stmt.h"
 #include "errors.h"
+#include "compilation.h"
 #include <iostream>
 #include <string>
 #include <vector>
         
-std::string Decl::GetName(){
-    return this->id->name;
-}
 
 
-Decl::Decl(Identifier *n) : Node(*n->GetLocation()) {
+Decl::Decl(NodeKind k, Identifier *n) : Node(k, *n->GetLocation()) {
     Assert(n != NULL);
     (id=n)->SetParent(this); 
 }
 
 
-VarDecl::VarDecl(Identifier *n, Type *t) : Decl(n) {
+VarDecl::VarDecl(Identifier *n, Type *t) : Decl(KindVarDecl, n) {
     Assert(n != NULL && t != NULL);
     (type=t)->SetParent(this);
 }
@@ -55,7 +53,7 @@ void VarDecl::Check() {
 }
   
 
-ClassDecl::ClassDecl(Identifier *n, NamedType *ex, List<NamedType*> *imp, List<Decl*> *m) : Decl(n) {
+ClassDecl::ClassDecl(Identifier *n, NamedType *ex, List<NamedType*> *imp, List<Decl*> *m) : Decl(KindClassDecl, n) {
     // extends can be NULL, impl & mem may be empty lists but cannot be NULL
     Assert(n != NULL && imp != NULL && m != NULL);     
     extends = ex;
@@ -63,6 +61,8 @@ ClassDecl::ClassDecl(Identifier *n, NamedType *ex, List<NamedType*> *imp, List<D
     (implements=imp)->SetParentAll(this);
     (members=m)->SetParentAll(this);
     extendedClass = NULL;
+    preorder = lastDescendant = -1;
+    numFields = numMethods = 0;
 }
 
 void ClassDecl::InitClassScope(ClassDecl* base_class){
@@ -70,14 +70,15 @@ void ClassDecl::InitClassScope(ClassDecl* base_class){
    if (base_class) {
       for (int i = 0; i < this->members->NumElements(); i++) {
          Decl* member = this->members->Nth(i);
-         std::string member_name = member->GetName();
-         //check if name is in base class scope
-         if (base_class->scope.find(member_name) != base_class->scope.end()) {
-           Decl* base_decl = base_class->scope[member_name];
+         Symbol member_name = member->GetSymbol();
+         //check if name is in base class or any of its ancestors
+         Member* inherited = base_class->FindMember(member_name);
+         if (inherited) {
+           Decl* base_decl = inherited->decl;
            //check if decl is func
-           FnDecl *base_function_decl = dynamic_cast<FnDecl*>(base_decl);
+           FnDecl *base_function_decl = dyn_cast<FnDecl>(base_decl);
            if (base_function_decl) {
-             FnDecl* member_function_decl = dynamic_cast<FnDecl*>(member);
+             FnDecl* member_function_decl = dyn_cast<FnDecl>(member);
              // if this member is also a function
              if (member_function_decl){
               // assign matching extends to member
@@ -104,30 +105,61 @@ void ClassDecl::InitClassScope(ClassDecl* base_class){
      InitScope(this->members);
    }
 }
-void ClassDecl::Check() {
-    Node *program = this->parent;
-    while (program->parent != NULL) {
-      program = program->parent;
+/* Function: BuildMemberTable
+ * ---------------------------
+ * Starts from a copy of the base class's table and adds this class's
+ * members, giving each new field and method the next slot. A method
+ * with the name of an inherited method overrides it in its slot. Any
+ * other clash is a conflict that InitClassScope reports; the table keeps
+ * the inherited member, or the first of two members of this class.
+ */
+void ClassDecl::BuildMemberTable() {
+  if (extendedClass) {
+    memberTable = extendedClass->memberTable;
+    numFields = extendedClass->numFields;
+    numMethods = extendedClass->numMethods;
+  }
+  std::vector<bool> own(numMethods, false);   // slots this class has filled
+  for (int i = 0; i < members->NumElements(); i++) {
+    Decl* member = members->Nth(i);
+    std::pair<MemberTable::iterator, bool> added =
+        memberTable.insert(std::make_pair(member->GetSymbol(), Member()));
+    Member &entry = added.first->second;
+    if (added.second) {
+      entry.decl = member;
+      entry.slot = isa<FnDecl>(member) ? numMethods++ : numFields++;
+      if (isa<FnDecl>(member)) own.push_back(true);
+    } else if (isa<FnDecl>(member) && isa<FnDecl>(entry.decl) && !own[entry.slot]) {
+      entry.decl = member;
+      own[entry.slot] = true;
     }
+  }
+}
+
+Member *ClassDecl::FindMember(Symbol name) {
+  MemberTable::iterator found = memberTable.find(name);
+  return found == memberTable.end() ? NULL : &found->second;
+}
+
+void ClassDecl::Declare() {
     //check if extends base class exists
     ClassDecl* base_class = NULL;
     if (this->extends) {
       NamedType* base_type = this->extends;
-      string base_type_name = base_type->GetName();
-      base_class = dynamic_cast<ClassDecl*>(FindDecl(base_type_name));
-      // If it's not defined, throw an error
+      Symbol base_type_name = base_type->GetSymbol();
+      base_class = dyn_cast<ClassDecl>(FindDecl(base_type_name));
+      // If it's not defined, throw an error (ClassHierarchy has
+      // already linked extendedClass)
       if (base_class == NULL){
         ReportError::IdentifierNotDeclared(base_type->id, reasonT::LookingForClass);
-      } else {
-        this->extendedClass = base_class;
       }
     }
    //check if implements interfaces exist
    for (int i = 0; i < this->implements->NumElements(); i++) {
       NamedType* base_type = this->implements->Nth(i);
-      string base_type_name = base_type->GetName();
+      Symbol base_type_name = base_type->GetSymbol();
       // If it's not defined, throw an error
-      InterfaceDecl *interface = dynamic_cast<InterfaceDecl*>(FindDecl(base_type_name));
+      InterfaceDecl *interface = dyn_cast<InterfaceDecl>(FindDecl(base_type_name));
       if (!interface){
         ReportError::IdentifierNotDeclared(base_type->id, reasonT::LookingForInterface);
       } else {
@@ -144,27 +176,33 @@ void ClassDecl::Check() {
       ReportError::InterfaceNotImplemented(this, interface_type);
     }
    }
-   
-    // Check the members
+}
+
+void ClassDecl::Check() {
+    // Check the members, with this as the class they are in
+   Compilation *unit = Compilation::Current();
+   ClassDecl *outer = unit->currentClass;
+   unit->currentClass = this;
    for (int i = 0; i < this->members->NumElements(); ++i){
     Decl* member = this->members->Nth(i);
     member->Check();
    }
+   unit->currentClass = outer;
 }
 
 bool ClassDecl::ValidateInterface(InterfaceDecl* interface){
   // Look through interface members for this class
   for (int i = 0; i < interface->members->NumElements(); ++i){
     Decl* member = interface->members->Nth(i);
-    FnDecl* impl_function = dynamic_cast<FnDecl*>(member);
+    FnDecl* impl_function = dyn_cast<FnDecl>(member);
     // If this this thing is legit interface
     if (impl_function) {
-      std::string function_name = impl_function->GetName();
+      Symbol function_name = impl_function->GetSymbol();
       // we don't have jawn
       if (this->scope.find(function_name) == this->scope.end()){
         return false;
       }
-      FnDecl* class_func = dynamic_cast<FnDecl*>(this->scope[function_name]);
+      FnDecl* class_func = dyn_cast<FnDecl>(this->scope[function_name]);
       // we have it but shit's not a function
       if (!class_func){
         return false;
@@ -182,13 +220,13 @@ bool ClassDecl::ValidateInterface(InterfaceDecl* interface){
   return true;
 }
 
-InterfaceDecl::InterfaceDecl(Identifier *n, List<Decl*> *m) : Decl(n) {
+InterfaceDecl::InterfaceDecl(Identifier *n, List<Decl*> *m) : Decl(KindInterfaceDecl, n) {
     Assert(n != NULL && m != NULL);
     (members=m)->SetParentAll(this);
 }
 
 
-void InterfaceDecl::Check(){
+void InterfaceDecl::Declare(){
   InitScope(members);
   // for (int i = 0; i < members->NumElements(); ++i){
   //   Decl* member = members->Nth(i);
@@ -196,7 +234,7 @@ void InterfaceDecl::Check(){
   // }
 }
 	
-FnDecl::FnDecl(Identifier *n, Type *r, List<VarDecl*> *d) : Decl(n) {
+FnDecl::FnDecl(Identifier *n, Type *r, List<VarDecl*> *d) : Decl(KindFnDecl, n) {
     Assert(n != NULL && r!= NULL && d != NULL);
     (returnType=r)->SetParent(this);
     (formals=d)->SetParentAll(this);
@@ -208,23 +246,8 @@ void FnDecl::SetFunctionBody(Stmt *b) {
 }
 
 bool isSameType(Type* first, Type* second){
-  NamedType* other_type = dynamic_cast<NamedType*>(second);
-  NamedType* our_type = dynamic_cast<NamedType*>(first);
-  // If one is a named type and the other is not
-  if ((!our_type && other_type) || (our_type && other_type)){
-    return false;
-  }
-  else if (our_type){
-    if (our_type->GetName() != other_type->GetName()){
-      return false;
-    }
-  }
-  else {
-    if (!first->IsEquivalentTo(second)){
-      return false;
-    } 
-  }
-  return true;
+  TypeTable *types = TypeTable::Current();
+  return types->Canonical(first) == types->Canonical(second);
 }
 
 bool FnDecl::isSameSignature(FnDecl *other){
@@ -245,6 +268,14 @@ bool FnDecl::isSameSignature(FnDecl *other){
   return true;
 }
 
+void FnDecl::DeclareLocals(){
+   // initialize scope with parameters
+   for (int i = 0; i < formals->NumElements(); ++i){
+      Decl* currentDecl = formals->Nth(i);
+      scope.insert(Scope::value_type(currentDecl->id->symbol, currentDecl));
+   }
+}
+
 void FnDecl::Check(){
     // Check return type
     returnType->Check();
@@ -270,20 +301,122 @@ void FnDecl::Check(){
        ReportError::OverrideMismatch(this);
      }
    }
-   // initialize scope with parameters
+   // report parameters that DeclareLocals left out of the scope
    for (int i = 0; i < formals->NumElements(); ++i){
       Decl* currentDecl = formals->Nth(i);
-      const char* name = currentDecl->id->name;
-      // report if this var already exists yo
-      if (scope.find(name) != scope.end()){
-        Decl* oldDecl = scope[name];
-        ReportError::DeclConflict(currentDecl, oldDecl);
-      } else{
-        scope[name] = currentDecl;
-      }
+      Decl* firstDecl = scope[currentDecl->id->symbol];
+      if (firstDecl != currentDecl)
+        ReportError::DeclConflict(currentDecl, firstDecl);
     }
     //Check Stmt Body
     if (body) body->Check();
 }
 
 
+ClassHierarchy *ClassHierarchy::Current() {
+  return Compilation::Current()->hierarchy;
+}
+
+/* Function: Build
+ * ---------------
+ * Links, numbers and sets the interface bits of the classes in decls,
+ * which are those of program. The classes are kept in declaration order
+ * throughout, so the numbering does not depend on hashing, and the
+ * extends tree is walked with an explicit stack since generated code
+ * can have chains of classes deeper than the C++ stack would like.
+ */
+void ClassHierarchy::Build(Program *program, List<Decl*> *decls) {
+  std::vector<ClassDecl*> classes;
+  for (int i = 0; i < decls->NumElements(); i++) {
+    ClassDecl* c = dyn_cast<ClassDecl>(decls->Nth(i));
+    if (!c) continue;
+    classes.push_back(c);
+    c->extendedClass = c->extends ?
+        dyn_cast<ClassDecl>(program->FindLocalDecl(c->extends->GetSymbol())) : NULL;
+  }
+
+  // Walk up from each class in turn, noting which walk reached each
+  // class first; meeting a class already seen on the same walk closes
+  // a cycle, which is broken at the link that closed it
+  std::unordered_map<ClassDecl*, ClassDecl*> reachedFrom;
+  for (size_t i = 0; i < classes.size(); i++) {
+    ClassDecl* start = classes[i];
+    ClassDecl* prev = NULL;
+    for (ClassDecl* c = start; c; prev = c, c = c->extendedClass) {
+      std::unordered_map<ClassDecl*, ClassDecl*>::iterator seen = reachedFrom.find(c);
+      if (seen != reachedFrom.end()) {
+        if (seen->second == start) prev->extendedClass = NULL;
+        break;
+      }
+      reachedFrom[c] = start;
+    }
+  }
+
+  // Number the classes in preorder, each root's tree in turn
+  std::unordered_map<ClassDecl*, std::vector<ClassDecl*> > subclasses;
+  std::vector<ClassDecl*> order, roots;
+  for (size_t i = 0; i < classes.size(); i++) {
+    ClassDecl* c = classes[i];
+    if (c->extendedClass) subclasses[c->extendedClass].push_back(c);
+    else roots.push_back(c);
+  }
+  for (size_t r = 0; r < roots.size(); r++) {
+    std::vector<std::pair<ClassDecl*, size_t> > stack;   // class, next subclass
+    roots[r]->preorder = order.size();
+    order.push_back(roots[r]);
+    stack.push_back(std::make_pair(roots[r], (size_t)0));
+    while (!stack.empty()) {
+      ClassDecl* c = stack.back().first;
+      std::vector<ClassDecl*> &below = subclasses[c];
+      if (stack.back().second < below.size()) {
+        ClassDecl* sub = below[stack.back().second++];
+        sub->preorder = order.size();
+        order.push_back(sub);
+        stack.push_back(std::make_pair(sub, (size_t)0));
+      } else {
+        c->lastDescendant = order.size() - 1;
+        stack.pop_back();
+      }
+    }
+  }
+
+  for (size_t i = 0; i < order.size(); i++)
+    order[i]->BuildMemberTable();
+
+  // Give each implemented name a bit, then each class its ancestors'
+  // bits and its own; preorder puts every class after its ancestors
+  interfaceBits.clear();
+  for (size_t i = 0; i < classes.size(); i++) {
+    List<NamedType*> *implements = classes[i]->implements;
+    for (int j = 0; j < implements->NumElements(); j++) {
+      Symbol name = implements->Nth(j)->GetSymbol();
+      if (interfaceBits.find(name) == interfaceBits.end()) {
+        int bit = interfaceBits.size();
+        interfaceBits[name] = bit;
+      }
+    }
+  }
+  size_t numWords = (interfaceBits.size() + 63) / 64;
+  for (size_t i = 0; i < order.size(); i++) {
+    ClassDecl* c = order[i];
+    if (c->extendedClass) c->interfaceBits = c->extendedClass->interfaceBits;
+    else c->interfaceBits.assign(numWords, 0);
+    for (int j = 0; j < c->implements->NumElements(); j++) {
+      int bit = interfaceBits[c->implements->Nth(j)->GetSymbol()];
+      c->interfaceBits[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+  }
+}
+
+bool ClassHierarchy::IsSubtype(ClassDecl* classDecl, Symbol name) {
+  if (!classDecl) return false;
+  Program *program = Compilation::Current()->program;
+  ClassDecl* named = dyn_cast<ClassDecl>(program->FindLocalDecl(name));
+  if (named && named->preorder <= classDecl->preorder &&
+      classDecl->preorder <= named->lastDescendant)
+    return true;
+  std::unordered_map<Symbol, int>::iterator found = interfaceBits.find(name);
+  if (found == interfaceBits.end()) return false;
+  int bit = found->second;
+  return (classDecl->interfaceBits[bit / 64] >> (bit % 64)) & 1;
+}
@@ -16,17 +16,26 @@
 #include "ast.h"
 #include "ast_type.h"
 #include "list.h"
+#include <stdint.h>
 #include <vector>
 
 class Identifier;
 class Stmt;
+class Program;
 
 class Decl : public Node 
 {
   public:
     Identifier *id;
-    std::string GetName();
-    Decl(Identifier *name);
+    Symbol GetSymbol()  { return id->symbol; }
+    Decl(NodeKind kind, Identifier *name);
+    static bool classof(Node *n) { return n->kind >= FirstDecl && n->kind <= LastDecl; }
+
+        // Fills in what other declarations can see of this one (a class's
+        // scope and the interfaces it implements, an interface's scope).
+        // Program::Check calls it on every declaration, in order, before
+        // it checks any of them.
+    virtual void Declare() {}
     friend std::ostream& operator<<(std::ostream& out, Decl *d) { return out << d->id; }
 };
 
@@ -35,6 +44,7 @@ class VarDecl : public Decl
   public:
     Type *type;
     VarDecl(Identifier *name, Type *type);
+    static bool classof(Node *n) { return n->kind == KindVarDecl; }
     void Check();
 };
 
@@ -42,10 +52,30 @@ class InterfaceDecl : public Decl
 {
   public:
     List<Decl*> *members;
+    Scope scope;
     InterfaceDecl(Identifier *name, List<Decl*> *members);
-    void Check();
+    static bool classof(Node *n) { return n->kind == KindInterfaceDecl; }
+    Scope *GetScope() { return &scope; }
+    void Declare();
 };
 
+/* Struct: Member
+ * --------------
+ * An entry in a class's member table: the field or method a name refers
+ * to in objects of the class, and its slot, which is the field's index
+ * among the object's fields or the method's index in the vtable. Slots
+ * count from the root of the class's extends chain, so an inherited
+ * member has the same slot in every subclass and an overriding method
+ * takes the slot of the method it overrides.
+ */
+struct Member
+{
+    Decl *decl;
+    int slot;
+};
+
+typedef std::unordered_map<Symbol, Member> MemberTable;
+
 class ClassDecl : public Decl 
 {
   public:
@@ -54,11 +84,21 @@ class ClassDecl : public Decl
     ClassDecl* extendedClass;
     List<NamedType*> *implements;
     std::unordered_map<NamedType*, InterfaceDecl*> interfaces;
+    Scope scope;
+    int preorder, lastDescendant;           // see ClassHierarchy
+    std::vector<uint64_t> interfaceBits;    // ditto
+    MemberTable memberTable;    // own and inherited members, by name
+    int numFields, numMethods;  // slots used, inherited ones included
 
     bool ValidateInterface(InterfaceDecl* interface);
     ClassDecl(Identifier *name, NamedType *extends, 
               List<NamedType*> *implements, List<Decl*> *members);
+    static bool classof(Node *n) { return n->kind == KindClassDecl; }
     void InitClassScope(ClassDecl* base_class);
+    void BuildMemberTable();
+    Member *FindMember(Symbol name);
+    Scope *GetScope() { return &scope; }
+    void Declare();
     void Check();
 };
 
@@ -72,10 +112,53 @@ class FnDecl : public Decl
     FnDecl *extends = NULL;
     FnDecl *implements = NULL;
     bool inherited_function_correct = true;
+    Scope scope;
     FnDecl(Identifier *name, Type *returnType, List<VarDecl*> *formals);
+    static bool classof(Node *n) { return n->kind == KindFnDecl; }
+    Scope *GetScope() { return &scope; }
     void SetFunctionBody(Stmt *b);
     bool isSameSignature(FnDecl* other);
+    void DeclareLocals();
     void Check();
 };
 
+
+/* Class: ClassHierarchy
+ * ---------------------
+ * Answers whether one class is a subtype of a named type with a couple
+ * of integer compares, however deep the inheritance. Once the program's
+ * scope is built, Build links each class to the class it extends and
+ * numbers the classes in preorder over the extends tree, so the classes
+ * derived from C, directly or not, are exactly those numbered from C's
+ * own number to its lastDescendant. Each name that appears in an
+ * implements list is given a bit, and each class the set of bits for
+ * the names it or any ancestor implements. An extends cycle is broken
+ * where it is found, so chains of extendedClass links always end.
+ * Each class's member table is then built from its base's, in preorder
+ * so the base's is always done first.
+ *
+ * Each compilation has one, built by Program::Check.
+ */
+class ClassHierarchy
+{
+  public:
+    void Build(Program *program, List<Decl*> *decls);
+
+        // Whether classDecl is, extends or implements the type named name.
+        // False if classDecl is NULL.
+    bool IsSubtype(ClassDecl *classDecl, Symbol name);
+
+        // Whether classDecl is base or derived from it
+    bool Extends(ClassDecl *classDecl, ClassDecl *base) {
+        return base->preorder <= classDecl->preorder &&
+               classDecl->preorder <= base->lastDescendant;
+    }
+
+        // The hierarchy of the current compilation
+    static ClassHierarchy *Current();
+
+  private:
+    std::unordered_map<Symbol, int> interfaceBits;   // bit for each implemented name
+};
+
 #endif
@@ -7,6 +7,7 @@
 #include "ast_decl.h"
 #include <string.h>
 #include "errors.h"
+#include "compilation.h"
 
 
 void Expr::Check(){
@@ -18,7 +19,7 @@ Type* Expr::GetType(){
 }
 
 
-IntConstant::IntConstant(yyltype loc, int val) : Expr(loc) {
+IntConstant::IntConstant(yyltype loc, int val) : Expr(KindIntConstant, loc) {
     value = val;
 }
 
@@ -26,7 +27,7 @@ Type* IntConstant::GetType() {
     return Type::intType;
 }
 
-DoubleConstant::DoubleConstant(yyltype loc, double val) : Expr(loc) {
+DoubleConstant::DoubleConstant(yyltype loc, double val) : Expr(KindDoubleConstant, loc) {
     value = val;
 }
 
@@ -34,7 +35,7 @@ Type* DoubleConstant::GetType() {
     return Type::doubleType;
 }
 
-BoolConstant::BoolConstant(yyltype loc, bool val) : Expr(loc) {
+BoolConstant::BoolConstant(yyltype loc, bool val) : Expr(KindBoolConstant, loc) {
     value = val;
 }
 
@@ -42,9 +43,9 @@ Type* BoolConstant::GetType() {
   return Type::boolType;
 }
 
-StringConstant::StringConstant(yyltype loc, const char *val) : Expr(loc) {
+StringConstant::StringConstant(yyltype loc, const char *val) : Expr(KindStringConstant, loc) {
     Assert(val != NULL);
-    value = strdup(val);
+    value = StrdupInCurrentArena(val);
 }
 
 Type* StringConstant::GetType() {
@@ -55,12 +56,12 @@ Type* NullConstant::GetType() {
   return Type::nullType;
 }
 
-Operator::Operator(yyltype loc, const char *tok) : Node(loc) {
+Operator::Operator(yyltype loc, const char *tok) : Node(KindOperator, loc) {
     Assert(tok != NULL);
     strncpy(tokenString, tok, sizeof(tokenString));
 }
-CompoundExpr::CompoundExpr(Expr *l, Operator *o, Expr *r) 
-  : Expr(Join(l->GetLocation(), r->GetLocation())) {
+CompoundExpr::CompoundExpr(NodeKind k, Expr *l, Operator *o, Expr *r) 
+  : Expr(k, Join(l->GetLocation(), r->GetLocation())) {
     Assert(l != NULL && o != NULL && r != NULL);
     (op=o)->SetParent(this);
     (left=l)->SetParent(this); 
@@ -261,8 +262,8 @@ Type* LValue::GetType(){
   return Type::errorType;
 }
 
-CompoundExpr::CompoundExpr(Operator *o, Expr *r) 
-  : Expr(Join(o->GetLocation(), r->GetLocation())) {
+CompoundExpr::CompoundExpr(NodeKind k, Operator *o, Expr *r) 
+  : Expr(k, Join(o->GetLocation(), r->GetLocation())) {
     Assert(o != NULL && r != NULL);
     left = NULL; 
     (op=o)->SetParent(this);
@@ -270,25 +271,15 @@ CompoundExpr::CompoundExpr(Operator *o, Expr *r)
 }
    
 Type* This::GetType(){
-    Node* current_node = this->GetParent();
-    ClassDecl* parent_class = NULL;
-    while (current_node){
-      ClassDecl* this_class = dynamic_cast<ClassDecl*>(current_node);
-      if (this_class){
-        parent_class = this_class;
-        break;
-      }
-      current_node = current_node->GetParent();
-    }
-   
+    ClassDecl* parent_class = Compilation::Current()->currentClass;
     if (!parent_class){
       ReportError::ThisOutsideClassScope(this);
       return Type::errorType;
     } else {
-      return new NamedType(parent_class->id);
+      return TypeTable::Current()->Named(parent_class->GetSymbol());
     }
 }
-ArrayAccess::ArrayAccess(yyltype loc, Expr *b, Expr *s) : LValue(loc) {
+ArrayAccess::ArrayAccess(yyltype loc, Expr *b, Expr *s) : LValue(KindArrayAccess, loc) {
     (base=b)->SetParent(this); 
     (subscript=s)->SetParent(this);
 }
@@ -305,7 +296,7 @@ Type* ArrayAccess::GetType() {
       ReportError::SubscriptNotInteger(subscript);
       return Type::errorType;
     }
-    ArrayType* base_array_type = dynamic_cast<ArrayType*>(base_type);
+    ArrayType* base_array_type = dyn_cast<ArrayType>(base_type);
     // Base expr is of array type;
     if (base_array_type) {
       return base_array_type->elemType;
@@ -316,29 +307,55 @@ Type* ArrayAccess::GetType() {
 }
      
 FieldAccess::FieldAccess(Expr *b, Identifier *f) 
-  : LValue(b? Join(b->GetLocation(), f->GetLocation()) : *f->GetLocation()) {
+  : LValue(KindFieldAccess, b? Join(b->GetLocation(), f->GetLocation()) : *f->GetLocation()) {
     Assert(f != NULL); // b can be be NULL (just means no explicit base)
     base = b; 
     if (base) base->SetParent(this); 
     (field=f)->SetParent(this);
+    var = NULL;
+    if (!base) Compilation::Current()->names.push_back(this);
+}
+
+/* Function: FindInScope
+ * ---------------------
+ * What name declares in the scope of node, if node opens one. In a class
+ * that is any of its members, inherited ones included.
+ */
+static Decl* FindInScope(Node* node, Symbol name) {
+  if (ClassDecl* class_decl = dyn_cast<ClassDecl>(node)) {
+    Member* member = class_decl->FindMember(name);
+    return member ? member->decl : NULL;
+  }
+  return node->FindLocalDecl(name);
+}
+
+/* Function: Bind
+ * ---------------
+ * Binds the access to the nearest variable named field in the scopes
+ * enclosing it, skipping anything else of that name, or to NULL if
+ * there is none.
+ */
+void FieldAccess::Bind() {
+  var = NULL;
+  for (Node* scope = this; scope && !var; scope = scope->parent)
+    var = dyn_cast<VarDecl>(FindInScope(scope, field->symbol));
+}
+
+/* Function: ResolveField
+ * ----------------------
+ * The variable named field among the members of classDecl, its own or
+ * inherited. The class the variable belongs to is its parent.
+ */
+VarDecl* FieldAccess::ResolveField(ClassDecl* class_decl) {
+  Member* member = class_decl->FindMember(field->symbol);
+  return member ? dyn_cast<VarDecl>(member->decl) : NULL;
 }
 
 Type* FieldAccess::GetType(){
   if (!base){
-    std::string name = field->name;
-    Node* parent = this;
-    Type* result = NULL;
-    // Look for the variable up your scope ladder
-    while (parent){
-      // If we have found the variable of question
-      if (parent->scope.find(name) != parent->scope.end()){
-        VarDecl* var = dynamic_cast<VarDecl*>(parent->scope[name]);
-        // Var has been found, return
-        if (var) {
-          return var->type;
-        }
-      }
-      parent = parent->parent;
+    // Var has been found, return
+    if (var) {
+      return TypeTable::Current()->Canonical(var->type);
     }
     // Var hasn't been found, return error
     ReportError::IdentifierNotDeclared(field,reasonT::LookingForVariable);
@@ -352,63 +369,26 @@ Type* FieldAccess::GetType(){
       return Type::errorType;
     }
     // Case base to named_type
-    NamedType* named_type = dynamic_cast<NamedType*>(base_type);
+    NamedType* named_type = dyn_cast<NamedType>(base_type);
     // If base is valid named_type
     if (named_type) {
-      // Look for class name in parent scopes
-      std::string class_name = named_type->GetName();
-      Node *current = this;
-      while (current->parent) {
-        current = current->parent;
-      }
+      // Look for class name in the program's scope
+      Symbol class_name = named_type->GetSymbol();
+      Program *program = Compilation::Current()->program;
       // Procure class Decl of this class name
-      Decl* lookup = current->scope[class_name];
-      ClassDecl* class_decl= dynamic_cast<ClassDecl*>(lookup);
+      Decl* lookup = program->FindLocalDecl(class_name);
+      ClassDecl* class_decl= dyn_cast<ClassDecl>(lookup);
       // If this class decl is valid, validate the var within the class
       if (class_decl) {
-        std::string var_name = field->name;
-        VarDecl* found_var_decl = NULL;
-        ClassDecl* found_class = NULL;
-        //variable not found in current class scope
-        if (class_decl->scope.find(var_name) == class_decl->scope.end()) {
-          // check in extends
-          ClassDecl* extended_class = class_decl->extendedClass;
-          while (extended_class) {
-            //found var name in a base class
-            if (extended_class->scope.find(var_name) != extended_class->scope.end()) {
-              found_var_decl = dynamic_cast<VarDecl*>(extended_class->scope[var_name]);
-              // Update the class to the one you found it in
-              if (found_var_decl) {
-                found_class = extended_class;
-                break;
-              }
-            }
-            extended_class = extended_class->extendedClass;
-          }
-          // If you never find it, this var is bogus
-          if (!found_var_decl) {
-            ReportError::IdentifierNotDeclared(field, LookingForVariable);
-            return Type::errorType;
-          }
-        }
-        // variable found in current class scope
-        else {
-          found_var_decl = dynamic_cast<VarDecl*>(class_decl->scope[var_name]);
-          found_class = class_decl;
-        }
+        VarDecl* found_var_decl = ResolveField(class_decl);
 
         //check for if var_decl was found within class scope
         if (found_var_decl) {
-          Node *current = this;
-          while (current) {
-            ClassDecl* current_class = dynamic_cast<ClassDecl*>(current);
-            while (current_class) {
-              if (current_class->GetName() == found_class->GetName()) {
-                return found_var_decl->type;
-              }
-              current_class = current_class->extendedClass;
-            }
-            current = current->parent;
+          ClassDecl* found_class = cast<ClassDecl>(found_var_decl->parent);
+          // Accessible only from that class and its subclasses
+          ClassDecl* current_class = Compilation::Current()->currentClass;
+          if (current_class && ClassHierarchy::Current()->Extends(current_class, found_class)) {
+            return TypeTable::Current()->Canonical(found_var_decl->type);
           }
           ReportError::InaccessibleField(field, base_type);
           return Type::errorType;
@@ -434,12 +414,14 @@ Type* FieldAccess::GetType(){
 }
 
 
-Call::Call(yyltype loc, Expr *b, Identifier *f, List<Expr*> *a) : Expr(loc)  {
+Call::Call(yyltype loc, Expr *b, Identifier *f, List<Expr*> *a) : Expr(KindCall, loc)  {
     Assert(f != NULL && a != NULL); // b can be be NULL (just means no explicit base)
     base = b;
     if (base) base->SetParent(this);
     (field=f)->SetParent(this);
     (actuals=a)->SetParentAll(this);
+    fn = NULL;
+    if (!base) Compilation::Current()->names.push_back(this);
 }
 
 void Call::CheckActuals() {
@@ -450,24 +432,33 @@ void Call::CheckActuals() {
   }
 }
 
+/* Function: Bind
+ * ---------------
+ * Binds the call to the nearest function named field in the scopes
+ * enclosing it, skipping anything else of that name, or to NULL if
+ * there is none.
+ */
+void Call::Bind() {
+  fn = NULL;
+  for (Node* scope = this; scope && !fn; scope = scope->parent)
+    fn = dyn_cast<FnDecl>(FindInScope(scope, field->symbol));
+}
+
+/* Function: ResolveMethod
+ * -----------------------
+ * The method named field among the members of classDecl, its own or
+ * inherited.
+ */
+FnDecl* Call::ResolveMethod(ClassDecl* class_decl) {
+  Member* member = class_decl->FindMember(field->symbol);
+  return member ? dyn_cast<FnDecl>(member->decl) : NULL;
+}
+
 Type* Call::GetType() {
     // for function of unspecified base
     FnDecl* found_func = NULL;
     if (!base) {
-      std::string name = field->name;
-      Node* parent = this;
-      Type* result = NULL;
-      while (parent){
-        // If we have found the function of question
-        if (parent->scope.find(name) != parent->scope.end()){
-          FnDecl* func = dynamic_cast<FnDecl*>(parent->scope[name]);
-          if (func) {
-            found_func = func;
-            break;
-          }
-        }
-        parent = parent->parent;
-      }
+      found_func = fn;
     }
     // there is a base
     else {
@@ -476,7 +467,7 @@ Type* Call::GetType() {
         CheckActuals();
         return Type::errorType;
       }
-      ArrayType* array_base = dynamic_cast<ArrayType*>(base_type);
+      ArrayType* array_base = dyn_cast<ArrayType>(base_type);
       // If the base type is an array, length or bust
       if (array_base) {
         if (strcmp(field->name, "length")){
@@ -499,39 +490,22 @@ Type* Call::GetType() {
         }
       }
       // Else type is named
-      NamedType* named_base = dynamic_cast<NamedType*>(base_type);
+      NamedType* named_base = dyn_cast<NamedType>(base_type);
       if (named_base){
-        std::string class_name = named_base->GetName();
-        Node *current = this;
-        while (current->parent) {
-          current = current->parent;
-        }
-        Decl* lookup = current->scope[class_name];
-        ClassDecl* class_decl= dynamic_cast<ClassDecl*>(lookup);
-        InterfaceDecl* intf_decl = dynamic_cast<InterfaceDecl*>(lookup);
+        Symbol class_name = named_base->GetSymbol();
+        Program *program = Compilation::Current()->program;
+        Decl* lookup = program->FindLocalDecl(class_name);
+        ClassDecl* class_decl= dyn_cast<ClassDecl>(lookup);
+        InterfaceDecl* intf_decl = dyn_cast<InterfaceDecl>(lookup);
         //base is a class
         if (class_decl) {
-          ClassDecl* current = class_decl;
-          while (current){
-          // If we have found the function of question
-            if (current->scope.find(field->name) != current->scope.end()){
-              FnDecl* func = dynamic_cast<FnDecl*>(current->scope[field->name]);
-              if (func) {
-                found_func = func;
-                break;
-              }
-            }
-            if (!current->extends) {
-              break;
-            }
-            current = current->extends->GetClassDecl();
-          }
+          found_func = ResolveMethod(class_decl);
         }
         // base is an interface
         else if (intf_decl) {
           // If this field exists within the interface
-          if (intf_decl->scope.find(field->name) != intf_decl->scope.end()) {
-            FnDecl* func = dynamic_cast<FnDecl*>(current->scope[field->name]);
+          if (intf_decl->FindLocalDecl(field->symbol)) {
+            FnDecl* func = dyn_cast<FnDecl>(program->FindLocalDecl(field->symbol));
             if (func) {
               if (func->implementedBy.size() > 0) {
                 found_func = func;
@@ -561,13 +535,13 @@ Type* Call::GetType() {
         //std::cout << "checking actual: " << i << std::endl;
         Expr* actual = actuals->Nth(i);
         Type* actual_type = actual->GetType();
-        Type* formal_type = found_func->formals->Nth(i)->type;
+        Type* formal_type = TypeTable::Current()->Canonical(found_func->formals->Nth(i)->type);
         if (!isCompatible(actual_type, formal_type)){
           ReportError::ArgMismatch(actual, i + 1, actual_type, formal_type);
           return Type::errorType;
         }
       }
-      return found_func->returnType;
+      return TypeTable::Current()->Canonical(found_func->returnType);
     // This field WAS NOT FOUND
     } else {
       // If there is a base
@@ -584,7 +558,7 @@ Type* Call::GetType() {
 }
  
 
-NewExpr::NewExpr(yyltype loc, NamedType *c) : Expr(loc) { 
+NewExpr::NewExpr(yyltype loc, NamedType *c) : Expr(KindNewExpr, loc) { 
   Assert(c != NULL);
   (cType=c)->SetParent(this);
 }
@@ -595,10 +569,10 @@ Type* NewExpr::GetType() {
     ReportError::IdentifierNotDeclared(cType->id, reasonT::LookingForClass);
     return Type::errorType;
   }
-  return cType;
+  return TypeTable::Current()->Canonical(cType);
 }
 
-NewArrayExpr::NewArrayExpr(yyltype loc, Expr *sz, Type *et) : Expr(loc) {
+NewArrayExpr::NewArrayExpr(yyltype loc, Expr *sz, Type *et) : Expr(KindNewArrayExpr, loc) {
     Assert(sz != NULL && et != NULL);
     (size=sz)->SetParent(this);
     (elemType=et)->SetParent(this);
@@ -632,7 +606,9 @@ Type* NewArrayExpr::GetType() {
     //   named_arr->Check();
     // }
     //std::cout << errored << std::endl;
-    return errored ? Type::errorType : new ArrayType(*this->location, elemType);
+    if (errored) return Type::errorType;
+    TypeTable *types = TypeTable::Current();
+    return types->ArrayOf(types->Canonical(elemType));
 }
 
        
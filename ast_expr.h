@@ -20,16 +20,23 @@
 
 class NamedType; // for new
 class Type; // for NewArray
+class VarDecl; class FnDecl; class ClassDecl; // for name bindings
 
 
 class Expr : public Stmt 
 {
   public:
     //Type* type;
-    Expr(yyltype loc) : Stmt(loc) {}
-    Expr() : Stmt() {}
+    Expr(NodeKind kind, yyltype loc) : Stmt(kind, loc) {}
+    Expr(NodeKind kind) : Stmt(kind) {}
+    static bool classof(Node *n) { return n->kind >= FirstExpr && n->kind <= LastExpr; }
     virtual Type* GetType();
     void Check();
+
+        // Binds an unqualified name to what it declares, for the field
+        // accesses and calls in Compilation::names. Program::Check calls
+        // it once every scope the name can see is filled.
+    virtual void Bind() { ; }
 };
 
 /* This node type is used for those places where an expression is optional.
@@ -38,62 +45,75 @@ class Expr : public Stmt
 class EmptyExpr : public Expr
 {
   public:
+    EmptyExpr() : Expr(KindEmptyExpr) {}
+    static bool classof(Node *n) { return n->kind == KindEmptyExpr; }
 };
 
 class IntConstant : public Expr 
 {
   protected:
     int value;
+    friend class AstWriter;   // to write it to an AST file
   
   public:
     Type* GetType();
     IntConstant(yyltype loc, int val);
+    static bool classof(Node *n) { return n->kind == KindIntConstant; }
 };
 
 class DoubleConstant : public Expr 
 {
   protected:
     double value;
+    friend class AstWriter;   // to write it to an AST file
     
   public:
     Type* GetType();
     DoubleConstant(yyltype loc, double val);
+    static bool classof(Node *n) { return n->kind == KindDoubleConstant; }
 };
 
 class BoolConstant : public Expr 
 {
   protected:
     bool value;
+    friend class AstWriter;   // to write it to an AST file
     
   public:
     Type* GetType();
     BoolConstant(yyltype loc, bool val);
+    static bool classof(Node *n) { return n->kind == KindBoolConstant; }
 };
 
 class StringConstant : public Expr 
 { 
   protected:
     char *value;
+    friend class AstWriter;   // to write it to an AST file
     
   public:
     Type* GetType();
     StringConstant(yyltype loc, const char *val);
+    static bool classof(Node *n) { return n->kind == KindStringConstant; }
 };
 
 class NullConstant: public Expr 
 {
   public: 
     Type* GetType();
-    NullConstant(yyltype loc) : Expr(loc) {}
+    NullConstant(yyltype loc) : Expr(KindNullConstant, loc) {}
+    static bool classof(Node *n) { return n->kind == KindNullConstant; }
 };
 
 class Operator : public Node 
 {
   protected:
     char tokenString[4];
+    friend class AstWriter;   // to write it to an AST file
     
   public:
     Operator(yyltype loc, const char *tok);
+    static bool classof(Node *n) { return n->kind == KindOperator; }
     friend std::ostream& operator<<(std::ostream& out, Operator *o) { return out << o->tokenString; }
  };
  
@@ -102,18 +122,23 @@ class CompoundExpr : public Expr
   protected:
     Operator *op;
     Expr *left, *right; // left will be NULL if unary
+    friend class AstWriter;   // to write it to an AST file
     
   public:
     virtual Type* GetType();
-    CompoundExpr(Expr *lhs, Operator *op, Expr *rhs); // for binary
-    CompoundExpr(Operator *op, Expr *rhs);             // for unary
+    CompoundExpr(NodeKind kind, Expr *lhs, Operator *op, Expr *rhs); // for binary
+    CompoundExpr(NodeKind kind, Operator *op, Expr *rhs);             // for unary
+    static bool classof(Node *n) {
+        return n->kind >= FirstCompoundExpr && n->kind <= LastCompoundExpr;
+    }
 };
 
 class ArithmeticExpr : public CompoundExpr 
 {
   public:
-    ArithmeticExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
-    ArithmeticExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
+    ArithmeticExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(KindArithmeticExpr,lhs,op,rhs) {}
+    ArithmeticExpr(Operator *op, Expr *rhs) : CompoundExpr(KindArithmeticExpr,op,rhs) {}
+    static bool classof(Node *n) { return n->kind == KindArithmeticExpr; }
     Type* GetType();
 };
 
@@ -121,14 +146,16 @@ class RelationalExpr : public CompoundExpr
 {
   public:
     Type* GetType();
-    RelationalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
+    RelationalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(KindRelationalExpr,lhs,op,rhs) {}
+    static bool classof(Node *n) { return n->kind == KindRelationalExpr; }
 };
 
 class EqualityExpr : public CompoundExpr 
 {
   public:
     Type* GetType();
-    EqualityExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
+    EqualityExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(KindEqualityExpr,lhs,op,rhs) {}
+    static bool classof(Node *n) { return n->kind == KindEqualityExpr; }
     const char *GetPrintNameForNode() { return "EqualityExpr"; }
 };
 
@@ -136,8 +163,9 @@ class LogicalExpr : public CompoundExpr
 {
   public:
     Type* GetType();
-    LogicalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
-    LogicalExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
+    LogicalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(KindLogicalExpr,lhs,op,rhs) {}
+    LogicalExpr(Operator *op, Expr *rhs) : CompoundExpr(KindLogicalExpr,op,rhs) {}
+    static bool classof(Node *n) { return n->kind == KindLogicalExpr; }
     const char *GetPrintNameForNode() { return "LogicalExpr"; }
 };
 
@@ -145,7 +173,8 @@ class AssignExpr : public CompoundExpr
 {
   public:
     Type* GetType();
-    AssignExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
+    AssignExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(KindAssignExpr,lhs,op,rhs) {}
+    static bool classof(Node *n) { return n->kind == KindAssignExpr; }
     const char *GetPrintNameForNode() { return "AssignExpr"; }
 };
 
@@ -153,13 +182,15 @@ class LValue : public Expr
 {
   public:
     virtual Type* GetType();
-    LValue(yyltype loc) : Expr(loc) {}
+    LValue(NodeKind kind, yyltype loc) : Expr(kind, loc) {}
+    static bool classof(Node *n) { return n->kind >= FirstLValue && n->kind <= LastLValue; }
 };
 
 class This : public Expr 
 {
   public:
-    This(yyltype loc) : Expr(loc) {}
+    This(yyltype loc) : Expr(KindThis, loc) {}
+    static bool classof(Node *n) { return n->kind == KindThis; }
     Type* GetType();
 };
 
@@ -167,10 +198,12 @@ class ArrayAccess : public LValue
 {
   protected:
     Expr *base, *subscript;
+    friend class AstWriter;   // to write it to an AST file
     
   public:
     Type* GetType();
     ArrayAccess(yyltype loc, Expr *base, Expr *subscript);
+    static bool classof(Node *n) { return n->kind == KindArrayAccess; }
 };
 
 /* Note that field access is used both for qualified names
@@ -183,10 +216,17 @@ class FieldAccess : public LValue
   protected:
     Expr *base;	// will be NULL if no explicit base
     Identifier *field;
+    VarDecl *var;   // what field names if there is no base, set by Bind
+    friend class AstWriter;   // to write it to an AST file
+
+        // The variable field names in a class and its bases
+    VarDecl *ResolveField(ClassDecl *classDecl);
 
   public:
+    void Bind();
     Type* GetType();
     FieldAccess(Expr *base, Identifier *field); //ok to pass NULL base
+    static bool classof(Node *n) { return n->kind == KindFieldAccess; }
 };
 
 /* Like field access, call is used both for qualified base.field()
@@ -199,10 +239,16 @@ class Call : public Expr
     Expr *base;	// will be NULL if no explicit base
     Identifier *field;
     List<Expr*> *actuals;
-    
+    FnDecl *fn;     // what field names if there is no base, set by Bind
+
+        // The method field names in a class and its bases
+    FnDecl *ResolveMethod(ClassDecl *classDecl);
+
+    void Bind();
     void CheckActuals();
     Type* GetType();
     Call(yyltype loc, Expr *base, Identifier *field, List<Expr*> *args);
+    static bool classof(Node *n) { return n->kind == KindCall; }
 };
 
 class NewExpr : public Expr
@@ -212,6 +258,7 @@ class NewExpr : public Expr
     
     Type* GetType();
     NewExpr(yyltype loc, NamedType *clsType);
+    static bool classof(Node *n) { return n->kind == KindNewExpr; }
 };
 
 class NewArrayExpr : public Expr
@@ -222,18 +269,21 @@ class NewArrayExpr : public Expr
     
     Type* GetType();
     NewArrayExpr(yyltype loc, Expr *sizeExpr, Type *elemType);
+    static bool classof(Node *n) { return n->kind == KindNewArrayExpr; }
 };
 
 class ReadIntegerExpr : public Expr
 {
   public:
-    ReadIntegerExpr(yyltype loc) : Expr(loc) {}
+    ReadIntegerExpr(yyltype loc) : Expr(KindReadIntegerExpr, loc) {}
+    static bool classof(Node *n) { return n->kind == KindReadIntegerExpr; }
 };
 
 class ReadLineExpr : public Expr
 {
   public:
-    ReadLineExpr(yyltype loc) : Expr (loc) {}
+    ReadLineExpr(yyltype loc) : Expr (KindReadLineExpr, loc) {}
+    static bool classof(Node *n) { return n->kind == KindReadLineExpr; }
 };
 
     
@@ -8,13 +8,58 @@
 #include "ast_expr.h"
 #include <iostream>
 #include "errors.h"
+#include "compilation.h"
+#include "stats.h"
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 
-Program::Program(List<Decl*> *d) {
+Program::Program(List<Decl*> *d) : Node(KindProgram) {
     Assert(d != NULL);
     (decls=d)->SetParentAll(this);
 }
 
+/* Function: CheckDecls
+ * ---------------------
+ * Checks decls, taking the next unchecked one from *next until there
+ * are none left, with the diagnostics for each appended to its entry
+ * in texts. Runs on each thread checking the program, in the current
+ * compilation of that thread.
+ */
+static void CheckDecls(List<Decl*> *decls, std::atomic<int> *next, std::vector<std::string> *texts)
+{
+    Compilation *unit = Compilation::Current();
+    std::ostream *errors = unit->errors;
+    int i;
+    while ((i = (*next)++) < decls->NumElements()) {
+      std::ostringstream text;
+      unit->errors = &text;
+      decls->Nth(i)->Check();
+      (*texts)[i] += text.str();
+    }
+    unit->errors = errors;
+}
+
+/* Function: HelpCheck
+ * -------------------
+ * The body of each extra thread checking the program of unit: it does
+ * its share in a helper compilation (see compilation.h) whose errors
+ * and measurements are added to unit's by the caller once it is done.
+ */
+static void HelpCheck(Compilation *unit, Compilation **helper, UnitStats *stats,
+                      List<Decl*> *decls, std::atomic<int> *next, std::vector<std::string> *texts)
+{
+    *helper = new Compilation(unit, stats);
+    Compilation::SetCurrent(*helper);
+    double cpuStart = CpuClock();
+    CheckDecls(decls, next, texts);
+    if (stats) stats->cpuSeconds[PhaseCheck] += CpuClock() - cpuStart;
+    Compilation::SetCurrent(NULL);
+}
+
 void Program::Check() {
     /* pp3: here is where the semantic analyzer is kicked off.
      *      The general idea is perform a tree traversal of the
@@ -22,34 +67,88 @@ void Program::Check() {
      *      with the semantic rules.  Each node can have its own way of
      *      checking itself, which makes for a great use of inheritance
      *      and polymorphism in the node classes.
+     *
+     * The program's scope and the class hierarchy come first. Then each
+     * declaration, in order, fills in what the others can see of it, and
+     * once the scopes of functions and blocks are filled too, each
+     * unqualified name is bound to what it declares. After that no
+     * declaration depends on another having been checked, and they are
+     * checked on up to Compilation::CheckThreads() threads.
+     * Each declaration's diagnostics are kept apart and written out in
+     * source order, so the output is the same however many threads
+     * there are.
      */
-    // Construct program's scope
-    this->InitScope(decls);
+    Compilation *unit = Compilation::Current();
+    UnitStats *stats = unit->stats;
+
+    // Construct program's scope and the class hierarchy
+    {
+      PhaseTimer timer(stats, PhaseScope);
+      this->InitScope(decls);
+      ClassHierarchy::Current()->Build(this, decls);
+    }
+
+    PhaseTimer timer(stats, PhaseCheck);
+    int numDecls = decls->NumElements();
+    std::vector<std::string> texts(numDecls);
+    std::ostream *errors = unit->errors;
+    for (int i = 0; i < numDecls; ++i){
+      std::ostringstream text;
+      unit->errors = &text;
+      decls->Nth(i)->Declare();
+      texts[i] = text.str();
+    }
+    unit->errors = errors;
+
+    // Bind the unqualified names, now that every scope they can see is
+    // filled, so checking only reads the bindings
+    for (size_t i = 0; i < unit->scopeNodes.size(); i++)
+      unit->scopeNodes[i]->DeclareLocals();
+    for (size_t i = 0; i < unit->names.size(); i++)
+      unit->names[i]->Bind();
 
     // Checking children
-    for (int i = 0; i < decls->NumElements(); ++i){
-      decls->Nth(i)->Check();
+    int numHelpers = std::min(Compilation::CheckThreads(), numDecls) - 1;
+    std::vector<std::thread> helpers;
+    std::vector<Compilation*> helperUnits(numHelpers > 0 ? numHelpers : 0);
+    std::vector<UnitStats> helperStats(helperUnits.size());
+    std::atomic<int> next(0);
+    for (int h = 0; h < numHelpers; h++)
+      helpers.push_back(std::thread(HelpCheck, unit, &helperUnits[h], stats ? &helperStats[h] : NULL,
+                                    decls, &next, &texts));
+    CheckDecls(decls, &next, &texts);
+    for (int h = 0; h < numHelpers; h++) {
+      helpers[h].join();
+      unit->numErrors += helperUnits[h]->numErrors;
+      if (stats) stats->Add(helperStats[h]);
+      delete helperUnits[h];
     }
+
+    for (int i = 0; i < numDecls; ++i)
+      *errors << texts[i];
 }
 
-StmtBlock::StmtBlock(List<VarDecl*> *d, List<Stmt*> *s) {
+StmtBlock::StmtBlock(List<VarDecl*> *d, List<Stmt*> *s) : Stmt(KindStmtBlock) {
     Assert(d != NULL && s != NULL);
     (decls=d)->SetParentAll(this);
     (stmts=s)->SetParentAll(this);
 }
 
+void StmtBlock::DeclareLocals() {
+   // initialize scope with variables
+   for (int i = 0; i < decls->NumElements(); ++i){
+      Decl* currentDecl = decls->Nth(i);
+      scope.insert(Scope::value_type(currentDecl->id->symbol, currentDecl));
+   }
+}
+
 void StmtBlock::Check() {
-   // initialize scope with parameters
+   // report variables that DeclareLocals left out of the scope
    for (int i = 0; i < decls->NumElements(); ++i){
       Decl* currentDecl = decls->Nth(i);
-      const char* name = currentDecl->id->name;
-      // report if this var already exists yo
-      if (scope.find(name) != scope.end()){
-        Decl* oldDecl = scope[name];
-        ReportError::DeclConflict(currentDecl, oldDecl);
-      } else{
-        scope[name] = currentDecl;
-      }
+      Decl* firstDecl = scope[currentDecl->id->symbol];
+      if (firstDecl != currentDecl)
+        ReportError::DeclConflict(currentDecl, firstDecl);
    }
    // Call check on VarDecls
    for (int i = 0; i < decls->NumElements(); ++i){
@@ -63,26 +162,26 @@ void StmtBlock::Check() {
    }
 }
 
-ConditionalStmt::ConditionalStmt(Expr *t, Stmt *b) { 
+ConditionalStmt::ConditionalStmt(NodeKind k, Expr *t, Stmt *b) : Stmt(k) { 
     Assert(t != NULL && b != NULL);
     (test=t)->SetParent(this); 
     (body=b)->SetParent(this);
 }
 
-ForStmt::ForStmt(Expr *i, Expr *t, Expr *s, Stmt *b): LoopStmt(t, b) { 
+ForStmt::ForStmt(Expr *i, Expr *t, Expr *s, Stmt *b): LoopStmt(KindForStmt, t, b) { 
     Assert(i != NULL && t != NULL && s != NULL && b != NULL);
     (init=i)->SetParent(this);
     (step=s)->SetParent(this);
 }
 
-IfStmt::IfStmt(Expr *t, Stmt *tb, Stmt *eb): ConditionalStmt(t, tb) { 
+IfStmt::IfStmt(Expr *t, Stmt *tb, Stmt *eb): ConditionalStmt(KindIfStmt, t, tb) { 
     Assert(t != NULL && tb != NULL); // else can be NULL
     elseBody = eb;
     if (elseBody) elseBody->SetParent(this);
 }
 
 
-ReturnStmt::ReturnStmt(yyltype loc, Expr *e) : Stmt(loc) { 
+ReturnStmt::ReturnStmt(yyltype loc, Expr *e) : Stmt(KindReturnStmt, loc) { 
     Assert(e != NULL);
     (expr=e)->SetParent(this);
 }
@@ -91,7 +190,7 @@ void ReturnStmt::Check() {
     
 }
   
-PrintStmt::PrintStmt(List<Expr*> *a) {    
+PrintStmt::PrintStmt(List<Expr*> *a) : Stmt(KindPrintStmt) {    
     Assert(a != NULL);
     (args=a)->SetParentAll(this);
 }
@@ -24,17 +24,23 @@ class Program : public Node
 {
   protected:
      List<Decl*> *decls;
+     friend class AstWriter;   // to write it to an AST file
      
   public:
+     Scope scope;
+
      Program(List<Decl*> *declList);
+     static bool classof(Node *n) { return n->kind == KindProgram; }
+     Scope *GetScope() { return &scope; }
      void Check();
 };
 
 class Stmt : public Node
 {
   public:
-     Stmt() : Node() {}
-     Stmt(yyltype loc) : Node(loc) {}
+     Stmt(NodeKind kind) : Node(kind) {}
+     Stmt(NodeKind kind, yyltype loc) : Node(kind, loc) {}
+     static bool classof(Node *n) { return n->kind >= FirstStmt && n->kind <= LastStmt; }
 };
 
 class StmtBlock : public Stmt 
@@ -42,9 +48,15 @@ class StmtBlock : public Stmt
   protected:
     List<VarDecl*> *decls;
     List<Stmt*> *stmts;
+    friend class AstWriter;   // to write it to an AST file
     
   public:
+    Scope scope;
+
     StmtBlock(List<VarDecl*> *variableDeclarations, List<Stmt*> *statements);
+    static bool classof(Node *n) { return n->kind == KindStmtBlock; }
+    Scope *GetScope() { return &scope; }
+    void DeclareLocals();
     void Check();
 };
 
@@ -54,65 +66,82 @@ class ConditionalStmt : public Stmt
   protected:
     Expr *test;
     Stmt *body;
+    friend class AstWriter;   // to write it to an AST file
   
   public:
-    ConditionalStmt(Expr *testExpr, Stmt *body);
+    ConditionalStmt(NodeKind kind, Expr *testExpr, Stmt *body);
+    static bool classof(Node *n) {
+        return n->kind >= FirstConditionalStmt && n->kind <= LastConditionalStmt;
+    }
 };
 
 class LoopStmt : public ConditionalStmt 
 {
   public:
-    LoopStmt(Expr *testExpr, Stmt *body)
-            : ConditionalStmt(testExpr, body) {}
+    LoopStmt(NodeKind kind, Expr *testExpr, Stmt *body)
+            : ConditionalStmt(kind, testExpr, body) {}
+    static bool classof(Node *n) {
+        return n->kind >= FirstLoopStmt && n->kind <= LastLoopStmt;
+    }
 };
 
 class ForStmt : public LoopStmt 
 {
   protected:
     Expr *init, *step;
+    friend class AstWriter;   // to write it to an AST file
   
   public:
     ForStmt(Expr *init, Expr *test, Expr *step, Stmt *body);
+    static bool classof(Node *n) { return n->kind == KindForStmt; }
 };
 
 class WhileStmt : public LoopStmt 
 {
   public:
-    WhileStmt(Expr *test, Stmt *body) : LoopStmt(test, body) {}
+    WhileStmt(Expr *test, Stmt *body) : LoopStmt(KindWhileStmt, test, body) {}
+    static bool classof(Node *n) { return n->kind == KindWhileStmt; }
 };
 
 class IfStmt : public ConditionalStmt 
 {
   protected:
     Stmt *elseBody;
+    friend class AstWriter;   // to write it to an AST file
   
   public:
     IfStmt(Expr *test, Stmt *thenBody, Stmt *elseBody);
+    static bool classof(Node *n) { return n->kind == KindIfStmt; }
 };
 
 class BreakStmt : public Stmt 
 {
   public:
-    BreakStmt(yyltype loc) : Stmt(loc) {}
+    BreakStmt(yyltype loc) : Stmt(KindBreakStmt, loc) {}
+    static bool classof(Node *n) { return n->kind == KindBreakStmt; }
 };
 
 class ReturnStmt : public Stmt  
 {
   protected:
     Expr *expr;
+    friend class AstWriter;   // to write it to an AST file
   
   public:
     void Check();
     ReturnStmt(yyltype loc, Expr *expr);
+    static bool classof(Node *n) { return n->kind == KindReturnStmt; }
 };
 
 class PrintStmt : public Stmt
 {
   protected:
     List<Expr*> *args;
+    friend class AstWriter;   // to write it to an AST file
     
   public:
     PrintStmt(List<Expr*> *arguments);
+    static bool classof(Node *n) { return n->kind == KindPrintStmt; }
 };
 
 
@@ -4,8 +4,11 @@
  */
 #include "ast_type.h"
 #include "ast_decl.h"
+#include "ast_stmt.h"
 #include <string.h>
 #include "errors.h"
+#include "compilation.h"
+#include "stats.h"
  
 /* Class constants
  * ---------------
@@ -23,47 +26,18 @@ Type *Type::nullType   = new Type("null");
 Type *Type::stringType = new Type("string");
 Type *Type::errorType  = new Type("error"); 
 
-Type::Type(const char *n) {
+Type::Type(const char *n) : Node(KindBuiltinType) {
     Assert(n);
-    typeName = strdup(n);
+    typeName = StrdupInCurrentArena(n);
 }
 
+// Both types are canonical (see TypeTable), so apart from a class
+// standing in for its bases, compatible types are the same pointer
 bool isCompatible(Type* lhs, Type* rhs){
-  ArrayType* lhs_array = dynamic_cast<ArrayType*>(lhs);
-  ArrayType* rhs_array = dynamic_cast<ArrayType*>(rhs); 
-  NamedType* lhs_named = dynamic_cast<NamedType*>(lhs);
-  NamedType* rhs_named = dynamic_cast<NamedType*>(rhs);
-  if (lhs_array){
-    // If the rhs is also an array
-    if (rhs_array) {
-      ArrayType* lhs_elem_array = dynamic_cast<ArrayType*>(lhs_array->elemType);
-      ArrayType* rhs_elem_array = dynamic_cast<ArrayType*>(rhs_array->elemType);
-      // Arrays of arrays
-      if (lhs_elem_array && rhs_elem_array) {
-        return isCompatible(rhs_array->elemType, lhs_array->elemType);
-      }
-      NamedType* lhs_elem_named = dynamic_cast<NamedType*>(lhs_array->elemType);
-      NamedType* rhs_elem_named = dynamic_cast<NamedType*>(rhs_array->elemType);
-      if (lhs_elem_named && rhs_elem_named) {
-        return lhs_elem_named->GetName() == rhs_elem_named->GetName(); 
-      } else {
-        return lhs_array->elemType == rhs_array->elemType;
-      }
-    } else if (lhs == Type::nullType){
-      return true;
-    } else {
-      return false;
-    }
-  }
-  //
-  if (lhs_named) {
-    if (rhs_named){
-      return lhs_named->Compatible(rhs_named);
-    } else if (lhs == Type::nullType){
-      return true;
-    } else {
-      return false;
-    }
+  NamedType* lhs_named = dyn_cast<NamedType>(lhs);
+  NamedType* rhs_named = dyn_cast<NamedType>(rhs);
+  if (lhs_named && rhs_named) {
+    return lhs_named->Compatible(rhs_named);
   }
   return lhs == rhs;
 }
@@ -71,42 +45,18 @@ void Type::Check(){
 }
 
 ClassDecl* NamedType::GetClassDecl(){
-  std::string name = this->id->name;
-  Node* program = this;
-  // Keep bubbling up while you have parents
-  while (program->parent) {
-    program = program->parent;
-  }
-  if (program->scope.find(name) != program->scope.end()) {
-    ClassDecl* class_decl = dynamic_cast<ClassDecl*>(program->scope[name]);
-    if (class_decl) {
-      return class_decl;
-    }
-  }
-  return NULL;
+  Symbol name = this->id->symbol;
+  Program* program = Compilation::Current()->program;
+  return dyn_cast<ClassDecl>(program->FindLocalDecl(name));
 }
 
-NamedType::NamedType(Identifier *i) : Type(*i->GetLocation()) {
+NamedType::NamedType(Identifier *i) : Type(KindNamedType, i->location) {
     Assert(i != NULL);
     (id=i)->SetParent(this);
 } 
 
 bool NamedType::Compatible(NamedType* other) {
-  ClassDecl* my_class = this->GetClassDecl();
-  // If the two classes have the same name
-  while (my_class) {
-    if (my_class->GetName() == other->GetName()) {
-      return true;
-    }
-    for (int i = 0; i < my_class->implements->NumElements(); i++) {
-      NamedType* implType = my_class->implements->Nth(i);
-      if (implType->GetName() == other->GetName()) {
-        return true;
-      }
-    }
-    my_class = my_class->extendedClass;
-  }
-  return false;
+  return ClassHierarchy::Current()->IsSubtype(this->GetClassDecl(), other->GetSymbol());
 }
 
 bool NamedType::isEquivalentTo(Type *o) {
@@ -115,54 +65,36 @@ bool NamedType::isEquivalentTo(Type *o) {
     std::cout << "NULL";
     return true;
   }
-  NamedType* other = dynamic_cast<NamedType*>(o);
-  ClassDecl* my_class = this->GetClassDecl();
-  // If the two classes have the same name
-  while (my_class) {
-    if (my_class->GetName() == other->GetName()) {
-      return true;
-    }
-    for (int i = 0; i < my_class->implements->NumElements(); i++) {
-      NamedType* implType = my_class->implements->Nth(i);
-      if (implType->GetName() == other->GetName()) {
-        return true;
-      }
-    }
-    my_class = my_class->extendedClass;
-  }
-  return false;
+  NamedType* other = dyn_cast<NamedType>(o);
+  return ClassHierarchy::Current()->IsSubtype(this->GetClassDecl(), other->GetSymbol());
 }
 
 void NamedType::Check(){
-  Node *program = this->parent;
-  // Look for parent
-  while (program->parent != NULL) {
-    program = program->parent;
-  }
+  Program *program = Compilation::Current()->program;
   Identifier* type_id = this->id;
-  std::string type_name = type_id->name;
+  Symbol type_name = type_id->symbol;
+  Decl* type_decl = program->FindLocalDecl(type_name);
   // Throw error if namedtype is not in program's scope
-  if (program->scope.find(type_name) == program->scope.end()){
+  if (!type_decl){
     ReportError::IdentifierNotDeclared(type_id, reasonT::LookingForType);
   } 
   // We found the namedtype, must ensure it is a Class/Interface
   else {
-    Decl* type_decl = program->scope[type_name];
-    ClassDecl* class_check = dynamic_cast<ClassDecl*>(type_decl);
-    InterfaceDecl* interface_check = dynamic_cast<InterfaceDecl*>(type_decl);
+    ClassDecl* class_check = dyn_cast<ClassDecl>(type_decl);
+    InterfaceDecl* interface_check = dyn_cast<InterfaceDecl>(type_decl);
     if (!(class_check || interface_check)) {
       ReportError::IdentifierNotDeclared(type_id, reasonT::LookingForType);
     }
   }
 }
 
-ArrayType::ArrayType(yyltype loc, Type *et) : Type(loc) {
+ArrayType::ArrayType(yyltype loc, Type *et) : Type(KindArrayType, loc) {
     Assert(et != NULL);
     (elemType=et)->SetParent(this);
 }
 
 bool ArrayType::isEquivalentTo(Type *o) {
-  ArrayType* other = dynamic_cast<ArrayType*>(o);
+  ArrayType* other = dyn_cast<ArrayType>(o);
   if (!other) {
     return o == Type::nullType;
   }
@@ -172,3 +104,46 @@ bool ArrayType::isEquivalentTo(Type *o) {
 void ArrayType::Check(){
   elemType->Check();
 }
+
+
+TypeTable *TypeTable::Current() {
+  return Compilation::Current()->types;
+}
+
+NamedType *TypeTable::Named(Symbol name) {
+  std::lock_guard<std::mutex> held(lock);
+  NamedType *&type = named[name];
+  if (!type) {
+    yyltype nowhere = { Node::NoLocation, 0 };
+    type = new NamedType(new Identifier(nowhere, name));
+    type->SetParent(Compilation::Current()->program);
+  }
+  return type;
+}
+
+ArrayType *TypeTable::ArrayOf(Type *elemType) {
+  std::lock_guard<std::mutex> held(lock);
+  ArrayType *&type = arrays[elemType];
+  if (!type) {
+    yyltype nowhere = { Node::NoLocation, 0 };
+    type = new ArrayType(nowhere, elemType);
+    type->SetParent(Compilation::Current()->program);
+  }
+  return type;
+}
+
+size_t TypeTable::BytesUsed() {
+  return HashMapBytes(named) + HashMapBytes(arrays) +
+         named.size() * (sizeof(NamedType) + sizeof(Identifier)) +
+         arrays.size() * sizeof(ArrayType);
+}
+
+Type *TypeTable::Canonical(Type *type) {
+  if (NamedType *named_type = dyn_cast<NamedType>(type)) {
+    return Named(named_type->GetSymbol());
+  }
+  if (ArrayType *array_type = dyn_cast<ArrayType>(type)) {
+    return ArrayOf(Canonical(array_type->elemType));
+  }
+  return type;
+}
@@ -15,7 +15,9 @@
 #include "ast.h"
 #include "list.h"
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 class ClassDecl;
 
 
@@ -28,8 +30,9 @@ class Type : public Node
     static Type *intType, *doubleType, *boolType, *voidType,
                 *nullType, *stringType, *errorType;
 
-    Type(yyltype loc) : Node(loc) {}
+    Type(NodeKind kind, yyltype loc) : Node(kind, loc) {}
     Type(const char *str);
+    static bool classof(Node *n) { return n->kind >= FirstType && n->kind <= LastType; }
     
     virtual void PrintToStream(std::ostream& out) { out << typeName; }
     friend std::ostream& operator<<(std::ostream& out, Type *t) { t->PrintToStream(out); return out; }
@@ -45,12 +48,13 @@ class NamedType : public Type
   public:
     ClassDecl* GetClassDecl();
     NamedType(Identifier *i);
+    static bool classof(Node *n) { return n->kind == KindNamedType; }
     void Check();
     bool Compatible(NamedType* other);
     bool isEquivalentTo(Type* other);
     void PrintToStream(std::ostream& out) { out << id; }
-    std::string GetName() {
-      return id->name;
+    Symbol GetSymbol() {
+      return id->symbol;
     }
 };
 
@@ -59,10 +63,47 @@ class ArrayType : public Type
   public:
     Type *elemType;
     ArrayType(yyltype loc, Type *elemType);
+    static bool classof(Node *n) { return n->kind == KindArrayType; }
     void Check();
     bool isEquivalentTo(Type* other);
     void PrintToStream(std::ostream& out) { out << elemType << "[]"; }
 };
 
+
+/* Class: TypeTable
+ * ----------------
+ * The canonical types of one compilation: a single NamedType for each
+ * class or interface name and a single ArrayType for each element type,
+ * made the first time they are asked for. GetType always returns one of
+ * these (or a built-in type), so two types are the same exactly when
+ * they are the same pointer, and checking allocates no types of its own.
+ *
+ * The types written in the source stay ordinary tree nodes, since they
+ * carry the locations errors point at; Canonical maps one of those to
+ * its table entry. Table entries hang off the program, so looking up
+ * a class from one finds the same declarations the source's would.
+ * The table is shared by the threads checking a unit, so it is locked
+ * while it is searched or added to.
+ */
+class TypeTable
+{
+  public:
+    NamedType *Named(Symbol name);
+    ArrayType *ArrayOf(Type *elemType);     // elemType must be canonical
+    Type *Canonical(Type *type);
+
+        // How many types were made, and the memory they take, for --mem-report
+    int NumTypes()  { return named.size() + arrays.size(); }
+    size_t BytesUsed();
+
+        // The table of the current compilation
+    static TypeTable *Current();
+
+  private:
+    std::mutex lock;    // held while finding or adding a type
+    std::unordered_map<Symbol, NamedType*> named;
+    std::unordered_map<Type*, ArrayType*> arrays;
+};
+
 bool isCompatible(Type* lhs, Type* rhs);
 #endif
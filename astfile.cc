@@ -0,0 +1,715 @@
+/* File: astfile.cc
+ * ----------------
+ * Implementation of AST files: the writer walks a tree and lays it out
+ * as records, the reader turns the records back into nodes.
+ */
+
+#include "astfile.h"
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "ast_decl.h"
+#include "ast_expr.h"
+#include "ast_stmt.h"
+#include "ast_type.h"
+#include "compilation.h"
+#include "source.h"
+#include "symtab.h"
+#include "utility.h"
+
+static const char Magic[4] = { 'D', 'A', 'S', 'T' };
+static const uint32_t Version = 1;
+
+/* Struct: AstFileHeader
+ * ---------------------
+ * Starts the file. The source follows it directly, then two NULs, the
+ * strings and the records.
+ */
+struct AstFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t sourceLength;
+    uint32_t stringsOffset, stringsLength;   // in bytes, from the start of the file
+    uint32_t recordsOffset, recordsLength;   // likewise
+    uint32_t numRecords;
+};
+
+static const int NoLocationFlag = 0x80;   // or'ed into a record's kind
+
+// The built-in types are shared rather than part of any tree, so a
+// record for one just names which it is
+static Type **const BuiltinTypes[] = {
+    &Type::intType, &Type::doubleType, &Type::boolType, &Type::stringType,
+    &Type::voidType, &Type::nullType, &Type::errorType
+};
+static const int NumBuiltinTypes = sizeof(BuiltinTypes) / sizeof(BuiltinTypes[0]);
+
+
+/* Class: AstWriter
+ * ----------------
+ * Lays out a tree as records. Write visits a node's children first, so
+ * each is given its record number before the parent's record refers to
+ * it.
+ */
+class AstWriter
+{
+  public:
+    std::string strings;
+    std::string records;
+    int numRecords;
+
+    AstWriter(SymbolTable *symbols);
+    int Write(Node *node);   // returns the record number, -1 for NULL
+
+  private:
+    SymbolTable *symbols;
+    std::vector<int> symbolOffsets;   // of each symbol's name in strings, -1 if not there yet
+    int builtinRecords[NumBuiltinTypes];
+    int current;                      // record being written
+    unsigned int lastOffset;          // of the last location written
+
+    void Put(uint32_t n);
+    void PutSigned(int32_t n)  { Put(((uint32_t)n << 1) ^ (uint32_t)(n >> 31)); }
+    void Begin(Node *node);
+    void Ref(int record)       { Put(record < 0 ? 0 : current - record); }
+    void Ref(std::vector<int> &records);
+    void String(const char *text, size_t length);
+    void Name(Symbol s);
+    template <class T> std::vector<int> WriteAll(List<T*> *list);
+};
+
+AstWriter::AstWriter(SymbolTable *s) : symbols(s), symbolOffsets(s->NumSymbols(), -1) {
+    numRecords = 0;
+    lastOffset = 0;
+    for (int i = 0; i < NumBuiltinTypes; i++)
+        builtinRecords[i] = -1;
+}
+
+// Seven bits a byte, low bits first, the top bit set on all but the last
+void AstWriter::Put(uint32_t n) {
+    while (n >= 0x80) {
+        records.push_back((char)(n | 0x80));
+        n >>= 7;
+    }
+    records.push_back((char)n);
+}
+
+/* Function: Begin
+ * ---------------
+ * Starts the record for node with its kind and location. The location
+ * is written as the distance from the previous one, which is usually
+ * small since nodes are written in source order.
+ */
+void AstWriter::Begin(Node *node) {
+    current = numRecords++;
+    if (node->location.offset == Node::NoLocation) {
+        records.push_back((char)(node->kind | NoLocationFlag));
+        return;
+    }
+    records.push_back((char)node->kind);
+    PutSigned(node->location.offset - lastOffset);
+    Put(node->location.length);
+    lastOffset = node->location.offset;
+}
+
+void AstWriter::Ref(std::vector<int> &list) {
+    Put(list.size());
+    for (size_t i = 0; i < list.size(); i++)
+        Ref(list[i]);
+}
+
+void AstWriter::String(const char *text, size_t length) {
+    Put(strings.size());
+    Put(length);
+    strings.append(text, length);
+    strings.push_back('\0');
+}
+
+void AstWriter::Name(Symbol s) {
+    const char *name = symbols->Name(s);
+    size_t length = strlen(name);
+    if (symbolOffsets[s] < 0) {
+        symbolOffsets[s] = strings.size();
+        strings.append(name, length + 1);
+    }
+    Put(symbolOffsets[s]);
+    Put(length);
+}
+
+template <class T> std::vector<int> AstWriter::WriteAll(List<T*> *list) {
+    std::vector<int> written(list->NumElements());
+    for (int i = 0; i < list->NumElements(); i++)
+        written[i] = Write(list->Nth(i));
+    return written;
+}
+
+int AstWriter::Write(Node *node) {
+    if (!node) return -1;
+    switch (node->kind) {
+      case KindProgram: {
+        Program *n = cast<Program>(node);
+        std::vector<int> decls = WriteAll(n->decls);
+        Begin(n); Ref(decls);
+        break;
+      }
+      case KindIdentifier: {
+        Identifier *n = cast<Identifier>(node);
+        Begin(n); Name(n->symbol);
+        break;
+      }
+      case KindOperator: {
+        Operator *n = cast<Operator>(node);
+        Begin(n); records.append(n->tokenString, sizeof(n->tokenString));
+        break;
+      }
+      case KindVarDecl: {
+        VarDecl *n = cast<VarDecl>(node);
+        int id = Write(n->id), type = Write(n->type);
+        Begin(n); Ref(id); Ref(type);
+        break;
+      }
+      case KindFnDecl: {
+        FnDecl *n = cast<FnDecl>(node);
+        int id = Write(n->id), returnType = Write(n->returnType);
+        std::vector<int> formals = WriteAll(n->formals);
+        int body = Write(n->body);
+        Begin(n); Ref(id); Ref(returnType); Ref(formals); Ref(body);
+        break;
+      }
+      case KindClassDecl: {
+        ClassDecl *n = cast<ClassDecl>(node);
+        int id = Write(n->id), extends = Write(n->extends);
+        std::vector<int> implements = WriteAll(n->implements);
+        std::vector<int> members = WriteAll(n->members);
+        Begin(n); Ref(id); Ref(extends); Ref(implements); Ref(members);
+        break;
+      }
+      case KindInterfaceDecl: {
+        InterfaceDecl *n = cast<InterfaceDecl>(node);
+        int id = Write(n->id);
+        std::vector<int> members = WriteAll(n->members);
+        Begin(n); Ref(id); Ref(members);
+        break;
+      }
+      case KindBuiltinType: {
+        int which = 0;
+        while (which < NumBuiltinTypes && *BuiltinTypes[which] != node) which++;
+        Assert(which < NumBuiltinTypes);
+        if (builtinRecords[which] < 0) {
+            Begin(node); Put(which);
+            builtinRecords[which] = current;
+        }
+        return builtinRecords[which];
+      }
+      case KindNamedType: {
+        NamedType *n = cast<NamedType>(node);
+        int id = Write(n->id);
+        Begin(n); Ref(id);
+        break;
+      }
+      case KindArrayType: {
+        ArrayType *n = cast<ArrayType>(node);
+        int elemType = Write(n->elemType);
+        Begin(n); Ref(elemType);
+        break;
+      }
+      case KindStmtBlock: {
+        StmtBlock *n = cast<StmtBlock>(node);
+        std::vector<int> decls = WriteAll(n->decls);
+        std::vector<int> stmts = WriteAll(n->stmts);
+        Begin(n); Ref(decls); Ref(stmts);
+        break;
+      }
+      case KindForStmt: {
+        ForStmt *n = cast<ForStmt>(node);
+        int init = Write(n->init), test = Write(n->test), step = Write(n->step);
+        int body = Write(n->body);
+        Begin(n); Ref(init); Ref(test); Ref(step); Ref(body);
+        break;
+      }
+      case KindWhileStmt: {
+        WhileStmt *n = cast<WhileStmt>(node);
+        int test = Write(n->test), body = Write(n->body);
+        Begin(n); Ref(test); Ref(body);
+        break;
+      }
+      case KindIfStmt: {
+        IfStmt *n = cast<IfStmt>(node);
+        int test = Write(n->test), body = Write(n->body), elseBody = Write(n->elseBody);
+        Begin(n); Ref(test); Ref(body); Ref(elseBody);
+        break;
+      }
+      case KindReturnStmt: {
+        ReturnStmt *n = cast<ReturnStmt>(node);
+        int expr = Write(n->expr);
+        Begin(n); Ref(expr);
+        break;
+      }
+      case KindPrintStmt: {
+        PrintStmt *n = cast<PrintStmt>(node);
+        std::vector<int> args = WriteAll(n->args);
+        Begin(n); Ref(args);
+        break;
+      }
+      case KindIntConstant:
+        Begin(node); PutSigned(cast<IntConstant>(node)->value);
+        break;
+      case KindDoubleConstant: {
+        double value = cast<DoubleConstant>(node)->value;
+        Begin(node); records.append((const char *)&value, sizeof(value));
+        break;
+      }
+      case KindBoolConstant:
+        Begin(node); Put(cast<BoolConstant>(node)->value);
+        break;
+      case KindStringConstant: {
+        const char *value = cast<StringConstant>(node)->value;
+        Begin(node); String(value, strlen(value));
+        break;
+      }
+      case KindArithmeticExpr: case KindRelationalExpr: case KindEqualityExpr:
+      case KindLogicalExpr: case KindAssignExpr: {
+        CompoundExpr *n = cast<CompoundExpr>(node);
+        int left = Write(n->left), op = Write(n->op), right = Write(n->right);
+        Begin(n); Ref(left); Ref(op); Ref(right);
+        break;
+      }
+      case KindArrayAccess: {
+        ArrayAccess *n = cast<ArrayAccess>(node);
+        int base = Write(n->base), subscript = Write(n->subscript);
+        Begin(n); Ref(base); Ref(subscript);
+        break;
+      }
+      case KindFieldAccess: {
+        FieldAccess *n = cast<FieldAccess>(node);
+        int base = Write(n->base), field = Write(n->field);
+        Begin(n); Ref(base); Ref(field);
+        break;
+      }
+      case KindCall: {
+        Call *n = cast<Call>(node);
+        int base = Write(n->base), field = Write(n->field);
+        std::vector<int> actuals = WriteAll(n->actuals);
+        Begin(n); Ref(base); Ref(field); Ref(actuals);
+        break;
+      }
+      case KindNewExpr: {
+        NewExpr *n = cast<NewExpr>(node);
+        int cType = Write(n->cType);
+        Begin(n); Ref(cType);
+        break;
+      }
+      case KindNewArrayExpr: {
+        NewArrayExpr *n = cast<NewArrayExpr>(node);
+        int size = Write(n->size), elemType = Write(n->elemType);
+        Begin(n); Ref(size); Ref(elemType);
+        break;
+      }
+      case KindBreakStmt: case KindEmptyExpr: case KindNullConstant: case KindThis:
+      case KindReadIntegerExpr: case KindReadLineExpr:
+        Begin(node);   // nothing but the location
+        break;
+      default:
+        Failure("Cannot write a node of kind %d to an AST file", node->kind);
+    }
+    return current;
+}
+
+
+/* Class: AstReader
+ * ----------------
+ * Builds nodes from the records in order. Every read is checked against
+ * the end of the records and every reference against the kind of node
+ * the field needs, so a damaged file makes Load fail rather than build
+ * a broken tree; once something is wrong, the rest is not looked at.
+ */
+class AstReader
+{
+  public:
+    AstReader(const char *records, size_t length, const char *strings, size_t stringsLength);
+    Program *ReadProgram(uint32_t numRecords);
+
+  private:
+    const unsigned char *next, *end;   // the records not yet read
+    const char *strings;
+    size_t stringsLength;
+    std::vector<Node*> nodes;          // indexed by record number
+    unsigned int lastOffset;           // of the last location read
+    bool bad;
+
+    bool Bytes(void *dest, size_t n);
+    uint32_t Get();
+    int32_t GetSigned()  { uint32_t n = Get(); return (int32_t)((n >> 1) ^ -(n & 1)); }
+    const char *String(size_t *length);
+    template <class T> T *Ref(bool nullable);
+    template <class T> List<T*> *ListOf();
+    Node *ReadRecord();
+};
+
+AstReader::AstReader(const char *r, size_t length, const char *s, size_t sl) {
+    next = (const unsigned char *)r;
+    end = next + length;
+    strings = s;
+    stringsLength = sl;
+    lastOffset = 0;
+    bad = false;
+}
+
+bool AstReader::Bytes(void *dest, size_t n) {
+    if ((size_t)(end - next) < n) {
+        bad = true;
+        return false;
+    }
+    memcpy(dest, next, n);
+    next += n;
+    return true;
+}
+
+// Undoes AstWriter::Put
+uint32_t AstReader::Get() {
+    uint32_t n = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (next == end) break;
+        unsigned char byte = *next++;
+        n |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return n;
+    }
+    bad = true;
+    return 0;
+}
+
+// A NUL-terminated string in the string section
+const char *AstReader::String(size_t *length) {
+    uint32_t offset = Get();
+    *length = Get();
+    if (offset >= stringsLength || *length >= stringsLength - offset ||
+        strings[offset + *length] != '\0') {
+        bad = true;
+        return NULL;
+    }
+    return strings + offset;
+}
+
+template <class T> T *AstReader::Ref(bool nullable) {
+    uint32_t back = Get();
+    if (back == 0 || back > nodes.size()) {
+        if (back != 0 || !nullable) bad = true;
+        return NULL;
+    }
+    T *node = dyn_cast<T>(nodes[nodes.size() - back]);
+    if (!node) bad = true;
+    return node;
+}
+
+template <class T> List<T*> *AstReader::ListOf() {
+    uint32_t count = Get();
+    if (count > (size_t)(end - next)) {   // each reference is at least a byte
+        bad = true;
+        return NULL;
+    }
+    List<T*> *list = new List<T*>;
+    for (uint32_t i = 0; i < count; i++)
+        list->Append(Ref<T>(false));
+    return list;
+}
+
+Node *AstReader::ReadRecord() {
+    unsigned char kind;
+    yyltype loc = { Node::NoLocation, 0 };
+    if (!Bytes(&kind, 1)) return NULL;
+    if (kind & NoLocationFlag) {
+        kind &= ~NoLocationFlag;
+    } else {
+        loc.offset = lastOffset += GetSigned();
+        loc.length = Get();
+    }
+    if (bad) return NULL;
+
+    Node *node = NULL;
+    switch (kind) {
+      case KindProgram: {
+        List<Decl*> *decls = ListOf<Decl>();
+        if (!bad) node = new Program(decls);
+        break;
+      }
+      case KindIdentifier: {
+        size_t length;
+        const char *name = String(&length);
+        if (!bad) node = new Identifier(loc, Compilation::Current()->symbols->Intern(name, length));
+        break;
+      }
+      case KindOperator: {
+        char token[4];
+        if (!Bytes(token, sizeof(token))) break;
+        token[3] = '\0';
+        node = new Operator(loc, token);
+        break;
+      }
+      case KindVarDecl: {
+        Identifier *id = Ref<Identifier>(false);
+        Type *type = Ref<Type>(false);
+        if (!bad) node = new VarDecl(id, type);
+        break;
+      }
+      case KindFnDecl: {
+        Identifier *id = Ref<Identifier>(false);
+        Type *returnType = Ref<Type>(false);
+        List<VarDecl*> *formals = ListOf<VarDecl>();
+        Stmt *body = Ref<Stmt>(true);
+        if (bad) break;
+        FnDecl *fn = new FnDecl(id, returnType, formals);
+        if (body) fn->SetFunctionBody(body);
+        node = fn;
+        break;
+      }
+      case KindClassDecl: {
+        Identifier *id = Ref<Identifier>(false);
+        NamedType *extends = Ref<NamedType>(true);
+        List<NamedType*> *implements = ListOf<NamedType>();
+        List<Decl*> *members = ListOf<Decl>();
+        if (!bad) node = new ClassDecl(id, extends, implements, members);
+        break;
+      }
+      case KindInterfaceDecl: {
+        Identifier *id = Ref<Identifier>(false);
+        List<Decl*> *members = ListOf<Decl>();
+        if (!bad) node = new InterfaceDecl(id, members);
+        break;
+      }
+      case KindBuiltinType: {
+        uint32_t which = Get();
+        if (which < NumBuiltinTypes) return *BuiltinTypes[which];   // keeps its own location
+        break;
+      }
+      case KindNamedType: {
+        Identifier *id = Ref<Identifier>(false);
+        if (!bad) node = new NamedType(id);
+        break;
+      }
+      case KindArrayType: {
+        Type *elemType = Ref<Type>(false);
+        if (!bad) node = new ArrayType(loc, elemType);
+        break;
+      }
+      case KindStmtBlock: {
+        List<VarDecl*> *decls = ListOf<VarDecl>();
+        List<Stmt*> *stmts = ListOf<Stmt>();
+        if (!bad) node = new StmtBlock(decls, stmts);
+        break;
+      }
+      case KindForStmt: {
+        Expr *init = Ref<Expr>(false), *test = Ref<Expr>(false), *step = Ref<Expr>(false);
+        Stmt *body = Ref<Stmt>(false);
+        if (!bad) node = new ForStmt(init, test, step, body);
+        break;
+      }
+      case KindWhileStmt: {
+        Expr *test = Ref<Expr>(false);
+        Stmt *body = Ref<Stmt>(false);
+        if (!bad) node = new WhileStmt(test, body);
+        break;
+      }
+      case KindIfStmt: {
+        Expr *test = Ref<Expr>(false);
+        Stmt *body = Ref<Stmt>(false), *elseBody = Ref<Stmt>(true);
+        if (!bad) node = new IfStmt(test, body, elseBody);
+        break;
+      }
+      case KindBreakStmt:
+        node = new BreakStmt(loc);
+        break;
+      case KindReturnStmt: {
+        Expr *expr = Ref<Expr>(false);
+        if (!bad) node = new ReturnStmt(loc, expr);
+        break;
+      }
+      case KindPrintStmt: {
+        List<Expr*> *args = ListOf<Expr>();
+        if (!bad) node = new PrintStmt(args);
+        break;
+      }
+      case KindEmptyExpr:
+        node = new EmptyExpr();
+        break;
+      case KindIntConstant:
+        node = new IntConstant(loc, GetSigned());
+        break;
+      case KindDoubleConstant: {
+        double value;
+        if (Bytes(&value, sizeof(value)))
+            node = new DoubleConstant(loc, value);
+        break;
+      }
+      case KindBoolConstant:
+        node = new BoolConstant(loc, Get() != 0);
+        break;
+      case KindStringConstant: {
+        size_t length;
+        const char *value = String(&length);
+        if (!bad) node = new StringConstant(loc, value);
+        break;
+      }
+      case KindNullConstant:
+        node = new NullConstant(loc);
+        break;
+      case KindArithmeticExpr: case KindRelationalExpr: case KindEqualityExpr:
+      case KindLogicalExpr: case KindAssignExpr: {
+        bool unary = (kind == KindArithmeticExpr || kind == KindLogicalExpr);
+        Expr *left = Ref<Expr>(unary);
+        Operator *op = Ref<Operator>(false);
+        Expr *right = Ref<Expr>(false);
+        if (bad) break;
+        switch (kind) {
+          case KindArithmeticExpr:
+            node = left ? new ArithmeticExpr(left, op, right) : new ArithmeticExpr(op, right);
+            break;
+          case KindLogicalExpr:
+            node = left ? new LogicalExpr(left, op, right) : new LogicalExpr(op, right);
+            break;
+          case KindRelationalExpr: node = new RelationalExpr(left, op, right); break;
+          case KindEqualityExpr:   node = new EqualityExpr(left, op, right); break;
+          case KindAssignExpr:     node = new AssignExpr(left, op, right); break;
+        }
+        break;
+      }
+      case KindThis:
+        node = new This(loc);
+        break;
+      case KindArrayAccess: {
+        Expr *base = Ref<Expr>(false), *subscript = Ref<Expr>(false);
+        if (!bad) node = new ArrayAccess(loc, base, subscript);
+        break;
+      }
+      case KindFieldAccess: {
+        Expr *base = Ref<Expr>(true);
+        Identifier *field = Ref<Identifier>(false);
+        if (!bad) node = new FieldAccess(base, field);
+        break;
+      }
+      case KindCall: {
+        Expr *base = Ref<Expr>(true);
+        Identifier *field = Ref<Identifier>(false);
+        List<Expr*> *actuals = ListOf<Expr>();
+        if (!bad) node = new Call(loc, base, field, actuals);
+        break;
+      }
+      case KindNewExpr: {
+        NamedType *cType = Ref<NamedType>(false);
+        if (!bad) node = new NewExpr(loc, cType);
+        break;
+      }
+      case KindNewArrayExpr: {
+        Expr *size = Ref<Expr>(false);
+        Type *elemType = Ref<Type>(false);
+        if (!bad) node = new NewArrayExpr(loc, size, elemType);
+        break;
+      }
+      case KindReadIntegerExpr:
+        node = new ReadIntegerExpr(loc);
+        break;
+      case KindReadLineExpr:
+        node = new ReadLineExpr(loc);
+        break;
+    }
+    if (node && !bad) {
+        node->location = loc;   // as parsed, whatever the constructor worked out
+        return node;
+    }
+    bad = true;
+    return NULL;
+}
+
+Program *AstReader::ReadProgram(uint32_t numRecords) {
+    if (numRecords == 0 || numRecords > (size_t)(end - next)) return NULL;
+    nodes.reserve(numRecords);
+    for (uint32_t i = 0; i < numRecords && !bad; i++)
+        nodes.push_back(ReadRecord());
+    if (bad || next != end) return NULL;
+    return dyn_cast<Program>(nodes.back());
+}
+
+
+bool AstFile::Write(const char *fileName, Program *program, SourceBuffer *source) {
+    AstWriter writer(Compilation::Current()->symbols);
+    writer.Write(program);
+
+    AstFileHeader header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.sourceLength = source->Length();
+    header.stringsOffset = sizeof(header) + source->Length() + 2;
+    header.stringsLength = writer.strings.size();
+    header.recordsOffset = header.stringsOffset + header.stringsLength;
+    header.recordsLength = writer.records.size();
+    header.numRecords = writer.numRecords;
+
+    FILE *fp = fopen(fileName, "wb");
+    if (!fp) return false;
+    fwrite(&header, sizeof(header), 1, fp);
+    fwrite(source->Data(), 1, source->Length(), fp);
+    fwrite("\0\0", 1, 2, fp);
+    fwrite(writer.strings.data(), 1, writer.strings.size(), fp);
+    fwrite(writer.records.data(), 1, writer.records.size(), fp);
+    bool ok = !ferror(fp);
+    return (fclose(fp) == 0) && ok;
+}
+
+AstFile::AstFile(char *b, size_t size) {
+    base = b;
+    mappedSize = size;
+    AstFileHeader *header = (AstFileHeader *)base;
+    source = SourceBuffer::Borrow(base + sizeof(AstFileHeader), header->sourceLength);
+}
+
+AstFile::~AstFile() {
+    delete source;
+    munmap(base, mappedSize);
+}
+
+/* Function: Map
+ * -------------
+ * The mapping is private and writable, since the scanner is pointed at
+ * the source in it to quote lines for errors (see InitScanner). Only the
+ * layout of the sections is checked here; Load checks the records.
+ */
+AstFile *AstFile::Map(const char *fileName) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(AstFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = info.st_size;
+    void *base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    AstFileHeader *header = (AstFileHeader *)base;
+    uint64_t sourceEnd = sizeof(AstFileHeader) + (uint64_t)header->sourceLength + 2;
+    uint64_t stringsEnd = (uint64_t)header->stringsOffset + header->stringsLength;
+    uint64_t recordsEnd = (uint64_t)header->recordsOffset + header->recordsLength;
+    if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version ||
+        header->stringsOffset < sourceEnd || header->recordsOffset < stringsEnd ||
+        recordsEnd > size ||
+        ((char *)base)[sourceEnd - 2] != '\0' || ((char *)base)[sourceEnd - 1] != '\0') {
+        munmap(base, size);
+        return NULL;
+    }
+    return new AstFile((char *)base, size);
+}
+
+Program *AstFile::Load() {
+    AstFileHeader *header = (AstFileHeader *)base;
+    AstReader reader(base + header->recordsOffset, header->recordsLength,
+                     base + header->stringsOffset, header->stringsLength);
+    return reader.ReadProgram(header->numRecords);
+}
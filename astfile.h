@@ -0,0 +1,63 @@
+/* File: astfile.h
+ * ---------------
+ * An AST file holds a parsed program in binary form, so that sources
+ * which are checked over and over (a vendor library, say) can be parsed
+ * once with dcc --emit-ast and then checked with dcc --load-ast without
+ * being scanned or parsed again.
+ *
+ * The file is a header, the program's source text (kept so errors can
+ * quote its lines), a string section holding the string constants and
+ * each identifier's name once, and the tree as a sequence of records.
+ * Each node is one record: a byte for its kind, its location, then its
+ * fields. A child is written before its parent and referred to by how
+ * many records back it is, 0 standing for NULL; strings are referred to
+ * by offset into the string section. Lists are written inline in the
+ * parent's record as a count followed by references. Numbers are written
+ * in as few bytes as they need, and a location as the distance from the
+ * previous one, so most records take only a handful of bytes. With no
+ * pointers in it, the file can be mapped anywhere, and it is read in
+ * place in one pass, each record becoming a node in the current
+ * compilation's arena. The last record is the Program.
+ *
+ * The header and double constants are in the byte order of the machine
+ * that wrote the file, and the record kinds are NodeKind values, so
+ * Version must change whenever the node classes do.
+ */
+
+#ifndef _H_astfile
+#define _H_astfile
+
+#include <stddef.h>
+
+class Program;
+class SourceBuffer;
+
+
+class AstFile
+{
+  public:
+        // Writes program, parsed from source, to the named file.
+        // Returns false if it cannot be written.
+    static bool Write(const char *fileName, Program *program, SourceBuffer *source);
+
+        // Maps the named file, or returns NULL if it cannot be read or
+        // is not an AST file of this version
+    static AstFile *Map(const char *fileName);
+    ~AstFile();
+
+        // The source the tree was parsed from, valid as long as this is
+    SourceBuffer *Source()  { return source; }
+
+        // Builds the tree in the current compilation. Returns NULL if
+        // the records are malformed.
+    Program *Load();
+
+  private:
+    char *base;             // the mapping
+    size_t mappedSize;
+    SourceBuffer *source;   // points into the mapping
+
+    AstFile(char *base, size_t mappedSize);
+};
+
+#endif
@@ -0,0 +1,43 @@
+#!/bin/bash
+#
+# Benchmarks dcc on programs made by gendecaf; "make bench" builds both
+# and runs this. For each size it generates a valid program and one with
+# deliberate errors, checks each with --time-report, and prints lines/s,
+# peak RSS and the time per phase. Each result is also appended to
+# bench-results.tsv along with the commit, so runs can be compared.
+#
+# Settings come from the environment:
+#   BENCH_SEED     generator seed (default 1)
+#   BENCH_SIZES    program sizes, as for gendecaf -b (default "1K 64K 1M 16M")
+#   BENCH_INVALID  percentage of methods with errors in the invalid runs (default 10)
+#   BENCH_ARGS     extra gendecaf options, e.g. "-n 16 -d 4 -m 8 -e 6"
+
+seed=${BENCH_SEED:-1}
+sizes=${BENCH_SIZES:-"1K 64K 1M 16M"}
+invalid=${BENCH_INVALID:-10}
+results=bench-results.tsv
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+file=$(mktemp /tmp/bench-XXXXXX.decaf)
+trap 'rm -f $file' EXIT
+
+[ -f $results ] || printf "commit\tseed\tsize\targs\tinvalid\tlines\twall_ms\tlines_per_s\tpeak_rss_kb\tscan_ms\tparse_ms\tscope_ms\tcheck_ms\n" > $results
+
+printf "%-6s %-8s %10s %10s %12s %10s %9s %9s %9s %9s\n" \
+       size errors lines wall-ms lines/s rss-KB scan parse scope check
+for size in $sizes; do
+  for pct in 0 $invalid; do
+    ./gendecaf -s $seed -b $size -i $pct $BENCH_ARGS > $file 2> /dev/null
+    lines=$(wc -l < $file)
+    # the report comes last on stderr, after any diagnostics
+    report=$(./dcc --time-report $file 2>&1 > /dev/null | sed -n '/^dcc time report/,$p')
+    phase() { echo "$report" | awk -v p=$1 '$1 == p { print $2 }'; }
+    wall=$(phase total)
+    rss=$(echo "$report" | awk '/peak RSS/ { print $NF }')
+    rate=$(awk -v l=$lines -v ms=$wall 'BEGIN { printf "%.0f", (ms > 0 ? l * 1000 / ms : 0) }')
+    printf "%-6s %-8s %10d %10.1f %12d %10d %9.1f %9.1f %9.1f %9.1f\n" \
+           $size $pct% $lines $wall $rate $rss $(phase scan) $(phase parse) $(phase scope) $(phase check)
+    printf "%s\t%s\t%s\t%s\t%s\t%d\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n" \
+           $commit $seed $size "$BENCH_ARGS" $pct $lines $wall $rate $rss \
+           $(phase scan) $(phase parse) $(phase scope) $(phase check) >> $results
+  done
+done
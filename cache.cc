@@ -0,0 +1,88 @@
+/* File: cache.cc
+ * --------------
+ * Implementation of the on-disk result cache.
+ */
+
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <iostream>
+#include "sha256.h"
+#include "utility.h"
+
+static const char *const EntryMagic = "dcc-result 1";
+
+
+ResultCache::ResultCache(const char *d) : dir(d) {
+    numHits = numMisses = 0;
+    mkdir(d, 0777);   // an existing directory is fine
+}
+
+/* Function: BuildId
+ * -----------------
+ * Hash of this executable, computed once. If the executable cannot be
+ * read, falls back to the compile time, which still changes on rebuild.
+ */
+const std::string &ResultCache::BuildId() {
+    static std::string id;
+    if (id.empty()) {
+        Sha256 hash;
+        FILE *fp = fopen("/proc/self/exe", "rb");
+        if (fp) {
+            char chunk[65536];
+            size_t n;
+            while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+                hash.Update(chunk, n);
+            fclose(fp);
+        } else {
+            hash.Update(__DATE__ " " __TIME__, strlen(__DATE__ " " __TIME__));
+        }
+        id = hash.Finish();
+    }
+    return id;
+}
+
+std::string ResultCache::EntryPath(const char *source, size_t length) {
+    Sha256 hash;
+    hash.Update(BuildId().data(), BuildId().size());
+    hash.Update(source, length);
+    return dir + "/" + hash.Finish();
+}
+
+bool ResultCache::Lookup(const std::string &path, int *numErrors, std::string *diagnostics) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    int length;
+    char magic[32];
+    bool found = false;
+    if (fp) {
+        if (fgets(magic, sizeof(magic), fp) && strncmp(magic, EntryMagic, strlen(EntryMagic)) == 0 &&
+            fscanf(fp, "%d %d", numErrors, &length) == 2 && fgetc(fp) == '\n' && length >= 0) {
+            diagnostics->resize(length);
+            found = (length == 0 || fread(&(*diagnostics)[0], 1, length, fp) == (size_t)length);
+        }
+        fclose(fp);
+    }
+    PrintDebug("cache", "%s %s", found ? "Hit" : "Miss", path.c_str());
+    if (found) numHits++; else numMisses++;
+    return found;
+}
+
+void ResultCache::Store(const std::string &path, int numErrors, const std::string &diagnostics) {
+    char suffix[32];
+    sprintf(suffix, ".tmp%d", (int)getpid());
+    std::string tmpPath = path + suffix;
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (!fp) return;
+    fprintf(fp, "%s\n%d %d\n", EntryMagic, numErrors, (int)diagnostics.size());
+    fwrite(diagnostics.data(), 1, diagnostics.size(), fp);
+    if (fclose(fp) != 0 || rename(tmpPath.c_str(), path.c_str()) != 0)
+        unlink(tmpPath.c_str());
+}
+
+void ResultCache::PrintStats() {
+    std::cerr << "dcc: cache: " << numHits << (numHits == 1 ? " hit, " : " hits, ")
+              << numMisses << (numMisses == 1 ? " miss" : " misses") << std::endl;
+}
@@ -0,0 +1,48 @@
+/* File: cache.h
+ * -------------
+ * The result cache remembers what checking a source file produced, so
+ * that a later run over an unchanged file can replay the diagnostics
+ * without scanning, parsing or checking it again.
+ *
+ * Entries live in a directory, one file each, named by the SHA-256 of
+ * the dcc build ID followed by the source bytes. The build ID is a hash
+ * of the running executable, so a rebuilt dcc never sees results from
+ * an older checker. Each entry records the error count and diagnostic
+ * text. Entries are written to a temporary file and renamed into place,
+ * so concurrent runs sharing a directory never see a partial entry.
+ */
+
+#ifndef _H_cache
+#define _H_cache
+
+#include <string>
+
+
+class ResultCache
+{
+  public:
+    int numHits, numMisses;   // lookups that found an entry or did not
+
+    ResultCache(const char *dir);
+
+        // Names the entry for source. Take it before scanning source,
+        // which leaves a NUL in it wherever the scanner stopped.
+    std::string EntryPath(const char *source, size_t length);
+
+        // Sets numErrors and diagnostics from the named entry and returns
+        // true, or returns false if there is none.
+    bool Lookup(const std::string &path, int *numErrors, std::string *diagnostics);
+
+        // Records the result of checking the source the entry is named
+        // for. Failures are ignored, the cache is only an optimization.
+    void Store(const std::string &path, int numErrors, const std::string &diagnostics);
+
+        // Writes the hit/miss counts to stderr
+    void PrintStats();
+
+  private:
+    std::string dir;
+    static const std::string &BuildId();
+};
+
+#endif
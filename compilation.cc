@@ -0,0 +1,73 @@
+/* File: compilation.cc
+ * --------------------
+ * Implementation of the per-translation-unit state.
+ */
+
+#include "compilation.h"
+#include "arena.h"
+#include "symtab.h"
+#include "ast_type.h"
+#include "ast_decl.h"
+#include "stats.h"
+
+thread_local Compilation *Compilation::current = NULL;
+int Compilation::checkThreads = 1;
+
+Compilation::Compilation(const char *n, yyscan_t s, std::ostream *e) {
+    name = n;
+    scanner = s;
+    program = NULL;
+    currentClass = NULL;
+    errors = e;
+    numErrors = 0;
+    stats = NULL;
+    arena = new Arena;
+    symbols = new SymbolTable(arena);
+    types = new TypeTable;
+    hierarchy = new ClassHierarchy;
+    isHelper = false;
+}
+
+Compilation::Compilation(Compilation *unit, UnitStats *s) {
+    name = unit->name;
+    scanner = unit->scanner;
+    program = unit->program;
+    currentClass = NULL;
+    errors = NULL;
+    numErrors = 0;
+    stats = s;
+    arena = unit->arena;
+    symbols = unit->symbols;
+    types = unit->types;
+    hierarchy = unit->hierarchy;
+    isHelper = true;
+}
+
+Compilation::~Compilation() {
+    if (isHelper) return;
+    delete hierarchy;
+    delete types;
+    delete symbols;
+    delete arena;
+}
+
+void Compilation::MeasureMemory() {
+    for (size_t i = 0; i < scopeNodes.size(); i++) {
+        Node *node = scopeNodes[i];
+        stats->scopeBytes[node->kind] += HashMapBytes(*node->GetScope());
+        if (ClassDecl *c = dyn_cast<ClassDecl>(node))
+            stats->scopeBytes[node->kind] += HashMapBytes(c->memberTable);
+    }
+    stats->stringBytes += arena->StringBytes();
+    stats->numSymbols += symbols->NumSymbols();
+    stats->symbolBytes += symbols->BytesUsed();
+    stats->lineIndexBytes += LineIndexBytes(scanner);
+    stats->numTypes += types->NumTypes();
+    stats->typeBytes += types->BytesUsed();
+    stats->arenaBytes += arena->BytesAllocated();
+}
+
+Arena *CurrentArena() {
+    Compilation *unit = Compilation::Current();
+    return unit ? unit->arena : NULL;
+}
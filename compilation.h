@@ -0,0 +1,77 @@
+/* File: compilation.h
+ * -------------------
+ * A Compilation holds the state that belongs to one translation unit:
+ * the scanner reading it, the program the parser built from it, where
+ * its diagnostics go and how many have been reported, the arena its
+ * tree is allocated from, and the tables its identifiers and types are
+ * interned in. The driver makes one for each file it checks and
+ * installs it as the current compilation while that file is scanned,
+ * parsed and checked, so code that reports errors can find it without
+ * it being passed around. The current compilation is per thread, so
+ * units may be worked on concurrently.
+ *
+ * A unit's declarations may also be checked on several threads at once
+ * (see Program::Check). Each thread helping with that works in a helper
+ * compilation of its own, which shares the unit's tree and tables but
+ * has its own error stream, count and measurements, and its own record
+ * of the class being checked. Of the shared tables only the type table
+ * is added to while checking, and it takes a lock to do so.
+ */
+
+#ifndef _H_compilation
+#define _H_compilation
+
+#include <iostream>
+#include <vector>
+#include "scanner.h"   // for yyscan_t
+
+class Node;
+class Expr;
+class Program;
+class ClassDecl;
+class Arena;
+class SymbolTable;
+class TypeTable;
+class ClassHierarchy;
+struct UnitStats;
+
+class Compilation
+{
+  public:
+    const char *name;         // source file name, NULL for stdin
+    yyscan_t scanner;         // scanner reading this unit
+    Program *program;         // set by the parser, NULL if parsing failed
+    ClassDecl *currentClass;  // class whose members are being checked, NULL if none
+    std::ostream *errors;     // where diagnostics are written
+    int numErrors;            // number of diagnostics reported so far
+    UnitStats *stats;         // measurements for the reports, NULL if off
+    Arena *arena;             // holds the tree; whoever keeps program must keep this
+    SymbolTable *symbols;     // identifiers in the tree, by Symbol
+    TypeTable *types;         // canonical types, made while checking
+    ClassHierarchy *hierarchy;  // subtype index over the program's classes
+    std::vector<Node*> scopeNodes;  // nodes owning a scope, in the order made
+    std::vector<Expr*> names;       // unqualified field accesses and calls
+
+    Compilation(const char *name, yyscan_t scanner, std::ostream *errors);
+    Compilation(Compilation *unit, UnitStats *stats);  // a helper for unit
+    ~Compilation();           // releases the arena, and with it the tree,
+                              // unless this is a helper
+
+        // Adds the memory the unit uses to stats, which must be set
+    void MeasureMemory();
+
+        // The unit currently being worked on, set by the driver
+    static Compilation *Current()              { return current; }
+    static void SetCurrent(Compilation *unit)  { current = unit; }
+
+        // How many threads check each unit's declarations, 1 by default
+    static int CheckThreads()              { return checkThreads; }
+    static void SetCheckThreads(int n)     { checkThreads = n; }
+
+  private:
+    bool isHelper;            // shares the tables of another unit
+    static thread_local Compilation *current;
+    static int checkThreads;
+};
+
+#endif
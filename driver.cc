@@ -0,0 +1,515 @@
+/* File: driver.cc
+ * ---------------
+ * Implementation of the batch driver that checks one translation unit
+ * after another in the same process, or spreads them over a pool of
+ * worker processes.
+ */
+
+#include "driver.h"
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "utility.h"
+#include "errors.h"
+#include "parser.h"
+#include "compilation.h"
+#include "cache.h"
+#include "astfile.h"
+#include "source.h"
+#include "stats.h"
+
+
+/* Function: ReadFileList
+ * ----------------------
+ * Appends each non-blank line of the named file to inputs. Leading and
+ * trailing whitespace is stripped from each line.
+ */
+static void ReadFileList(const char *listName, List<const char*> *inputs)
+{
+    FILE *fp = fopen(listName, "r");
+    if (!fp) {
+        fprintf(stderr, "dcc: cannot open file list '%s'\n", listName);
+        exit(2);
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), fp)) {
+        char *start = line, *end = line + strlen(line);
+        while (*start == ' ' || *start == '\t') start++;
+        while (end > start && (end[-1] == '\n' || end[-1] == '\r' ||
+                               end[-1] == ' ' || end[-1] == '\t'))
+            *--end = '\0';
+        if (*start) inputs->Append(strdup(start));
+    }
+    fclose(fp);
+}
+
+static void Usage()
+{
+    printf("Usage:   dcc [-j N] [--threads N] [--cache DIR] [--time-report] [--mem-report] [file ... | @filelist ...] [-d <debug-key-1> ...]\n");
+    printf("         dcc [-j N] [--threads N] [--time-report] [--mem-report] --load-ast file.dast ... [-d <debug-key-1> ...]\n");
+    printf("         dcc --emit-ast out.dast [file] [-d <debug-key-1> ...]\n");
+    printf("         dcc --server[=socket-path] [-d <debug-key-1> ...]\n");
+    printf("         dcc --watch DIR [-d <debug-key-1> ...]\n");
+    exit(2);
+}
+
+void ParseDriverCommandLine(int argc, char *argv[], DriverOptions *options)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0) {
+            // the rest are debug keys, argv[i-1] stands in for the program name
+            ParseCommandLine(argc - (i - 1), argv + (i - 1));
+            break;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            const char *count = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : NULL);
+            char *end;
+            if (!count || (options->numJobs = strtol(count, &end, 10)) < 0 || *end)
+                Usage();
+            if (options->numJobs == 0)
+                options->numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+        } else if (strcmp(argv[i], "--threads") == 0 || strncmp(argv[i], "--threads=", 10) == 0) {
+            const char *count = argv[i][9] ? argv[i] + 10 : (i + 1 < argc ? argv[++i] : NULL);
+            char *end;
+            if (!count || !*count || (options->numThreads = strtol(count, &end, 10)) < 0 || *end)
+                Usage();
+            if (options->numThreads == 0)
+                options->numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+        } else if (strcmp(argv[i], "--time-report") == 0) {
+            options->timeReport = true;
+        } else if (strcmp(argv[i], "--mem-report") == 0) {
+            options->memReport = true;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            if (i + 1 >= argc) Usage();
+            options->cacheDir = argv[++i];
+        } else if (strncmp(argv[i], "--cache=", 8) == 0 && argv[i][8]) {
+            options->cacheDir = argv[i] + 8;
+        } else if (strcmp(argv[i], "--emit-ast") == 0) {
+            if (i + 1 >= argc) Usage();
+            options->emitAst = argv[++i];
+        } else if (strncmp(argv[i], "--emit-ast=", 11) == 0 && argv[i][11]) {
+            options->emitAst = argv[i] + 11;
+        } else if (strcmp(argv[i], "--load-ast") == 0) {
+            options->loadAst = true;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            if (i + 1 >= argc) Usage();
+            options->watchDir = argv[++i];
+        } else if (strncmp(argv[i], "--watch=", 8) == 0 && argv[i][8]) {
+            options->watchDir = argv[i] + 8;
+        } else if (strcmp(argv[i], "--server") == 0) {
+            options->server = true;
+        } else if (strncmp(argv[i], "--server=", 9) == 0 && argv[i][9]) {
+            options->server = true;
+            options->socketPath = argv[i] + 9;
+        } else if (argv[i][0] == '@') {
+            ReadFileList(argv[i] + 1, &options->inputs);
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            Usage();
+        } else {
+            options->inputs.Append(argv[i]);
+        }
+    }
+    // an AST file is written from one source and read back by mapping it
+    if ((options->emitAst && (options->loadAst || options->inputs.NumElements() > 1)) ||
+        (options->loadAst && options->inputs.NumElements() == 0))
+        Usage();
+}
+
+/* Function: ParseUnit
+ * -------------------
+ * Scans and parses the program in source as the given unit, which must
+ * be the current compilation. Afterwards unit->program holds the tree,
+ * if parsing got that far.
+ */
+static void ParseUnit(Compilation *unit, SourceBuffer *source)
+{
+    InitScanner(unit->scanner, source);
+    {
+        PhaseTimer timer(unit->stats, PhaseParse);
+        yyparse(unit->scanner, unit);
+    }
+    if (unit->stats) unit->stats->SeparateScanFromParse();
+}
+
+/* Function: FinishUnit
+ * --------------------
+ * Checks the unit's program, if it has one and no errors were reported
+ * getting it, and counts and measures the unit for the reports.
+ */
+static void FinishUnit(Compilation *unit)
+{
+    // if no errors, advance to next phase
+    if (unit->program && unit->numErrors == 0)
+        unit->program->Check();
+    if (unit->stats) {
+        unit->stats->numUnits++;
+        unit->stats->numDiagnostics += unit->numErrors;
+        unit->MeasureMemory();
+    }
+}
+
+/* Function: CheckUnit
+ * -------------------
+ * Scans, parses and checks the program in source as the given unit,
+ * which is made the current compilation meanwhile. Returns the number of
+ * errors reported for it.
+ */
+static int CheckUnit(Compilation *unit, SourceBuffer *source)
+{
+    Compilation::SetCurrent(unit);
+    PrintDebug("driver", "Checking %s", unit->name ? unit->name : "<stdin>");
+    ParseUnit(unit, source);
+    FinishUnit(unit);
+    Compilation::SetCurrent(NULL);
+    return unit->numErrors;
+}
+
+/* Function: CheckAstFile
+ * ----------------------
+ * Like CheckUnit, but the tree is loaded from the named AST file rather
+ * than parsed, and the scanner is only used to find lines in the source
+ * saved with it. Loading is timed as parsing.
+ */
+static int CheckAstFile(yyscan_t scanner, const char *fileName, std::ostream *errors,
+                        UnitStats *stats)
+{
+    Compilation unit(fileName, scanner, errors);
+    unit.stats = stats;
+    Compilation::SetCurrent(&unit);
+    PrintDebug("driver", "Loading %s", fileName);
+    AstFile *file = AstFile::Map(fileName);
+    if (file) {
+        InitScanner(scanner, file->Source());
+        PhaseTimer timer(stats, PhaseParse);
+        unit.program = file->Load();
+    }
+    if (!unit.program)
+        ReportError::Formatted(NULL, "Cannot read AST file '%s'", fileName);
+    FinishUnit(&unit);
+    Compilation::SetCurrent(NULL);
+    delete file;
+    return unit.numErrors;
+}
+
+bool ReadWholeFile(const char *fileName, std::string *contents)
+{
+    FILE *fp = fopen(fileName, "rb");
+    if (!fp) return false;
+    char chunk[65536];
+    size_t n;
+    contents->clear();
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+        contents->append(chunk, n);
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+/* Function: CheckFileCached
+ * -------------------------
+ * Like CheckFile, but replays the result from the cache when the file's
+ * contents have been checked before, and records it there when not.
+ */
+static int CheckFileCached(yyscan_t scanner, const char *fileName, SourceBuffer *source,
+                           std::ostream *errors, ResultCache *cache, UnitStats *stats)
+{
+    std::string entry = cache->EntryPath(source->Data(), source->Length());
+    std::string diagnostics;
+    int numErrors;
+    if (!cache->Lookup(entry, &numErrors, &diagnostics)) {
+        std::ostringstream captured;
+        Compilation unit(fileName, scanner, &captured);
+        unit.stats = stats;
+        numErrors = CheckUnit(&unit, source);
+        diagnostics = captured.str();
+        cache->Store(entry, numErrors, diagnostics);
+    }
+    *errors << diagnostics;
+    return numErrors;
+}
+
+/* Function: ReportUnreadable
+ * --------------------------
+ * Reports that the named source file (stdin if NULL) cannot be read, as
+ * an error of the current compilation.
+ */
+static void ReportUnreadable(const char *fileName)
+{
+    if (fileName)
+        ReportError::Formatted(NULL, "Cannot open file '%s'", fileName);
+    else
+        ReportError::Formatted(NULL, "Cannot read standard input");
+}
+
+/* Function: CheckFile
+ * -------------------
+ * Scans, parses and checks one translation unit using the given scanner,
+ * with diagnostics written to errors. The file is memory-mapped rather
+ * than read. Pass NULL to read the program from stdin, which is never
+ * cached. If astInput is set, the file is an AST file instead. If stats
+ * is not NULL, the unit's measurements are added to it. Returns the
+ * number of errors reported for that unit.
+ */
+static int CheckFile(yyscan_t scanner, const char *fileName, bool astInput,
+                     std::ostream *errors, ResultCache *cache, UnitStats *stats)
+{
+    if (astInput)
+        return CheckAstFile(scanner, fileName, errors, stats);
+    SourceBuffer *source = fileName ? SourceBuffer::Map(fileName) : SourceBuffer::Read(stdin);
+    int numErrors;
+    if (!source) {
+        Compilation unit(fileName, scanner, errors);
+        Compilation::SetCurrent(&unit);
+        ReportUnreadable(fileName);
+        Compilation::SetCurrent(NULL);
+        numErrors = unit.numErrors;
+    } else if (fileName && cache) {
+        numErrors = CheckFileCached(scanner, fileName, source, errors, cache, stats);
+    } else {
+        Compilation unit(fileName, scanner, errors);
+        unit.stats = stats;
+        numErrors = CheckUnit(&unit, source);
+    }
+    delete source;
+    return numErrors;
+}
+
+int CheckSource(Compilation *unit, SourceBuffer *source)
+{
+    return CheckUnit(unit, source);
+}
+
+void PrintStatus(const char *fileName, int numErrors)
+{
+    if (numErrors == 0)
+        std::cerr << fileName << ": ok" << std::endl;
+    else
+        std::cerr << fileName << ": " << numErrors
+                  << (numErrors == 1 ? " error" : " errors") << std::endl;
+}
+
+static int CheckFilesSerially(List<const char*> *inputs, bool astInput, ResultCache *cache,
+                              UnitStats *stats)
+{
+    yyscan_t scanner = NewScanner();
+    int numFailed = 0;
+    if (inputs->NumElements() == 0)
+        numFailed = (CheckFile(scanner, NULL, false, &std::cerr, cache, stats) > 0);
+    for (int i = 0; i < inputs->NumElements(); i++) {
+        const char *fileName = inputs->Nth(i);
+        int numErrors = CheckFile(scanner, fileName, astInput, &std::cerr, cache, stats);
+        if (numErrors > 0) numFailed++;
+        if (inputs->NumElements() > 1) PrintStatus(fileName, numErrors);
+    }
+    FreeScanner(scanner);
+    return numFailed;
+}
+
+
+/* Parallel checking
+ * -----------------
+ * The parser is pure, but every parse still links the shared built-in
+ * types (Type::intType and friends) into its own tree, so the workers
+ * are forked processes rather than threads; each one has its own
+ * scanner, AST and error count. Workers claim the next unchecked input
+ * from a counter in shared memory, check it with diagnostics going to a
+ * private buffer, and send the result back to the parent over a pipe as
+ * a UnitResult header followed by the diagnostic text. The parent prints
+ * results in input order as soon as all earlier ones are in. Each worker
+ * has its own copy of the result cache, so the hit and miss counts come
+ * back with the results and are added up in the parent, as are the
+ * --time-report and --mem-report measurements.
+ */
+struct UnitResult
+{
+    int index;       // position of the unit in the input list
+    int numErrors;
+    int textLength;  // bytes of diagnostic text that follow
+    int cacheHits, cacheMisses;
+    UnitStats stats;  // zero unless a report is on
+};
+
+static bool WriteAll(int fd, const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+static void RunWorker(List<const char*> *inputs, bool astInput, volatile int *nextIndex, int fd,
+                      ResultCache *cache, bool measure)
+{
+    yyscan_t scanner = NewScanner();
+    int index;
+    while ((index = __sync_fetch_and_add(nextIndex, 1)) < inputs->NumElements()) {
+        std::ostringstream diagnostics;
+        UnitResult result;
+        result.index = index;
+        int hitsBefore = cache ? cache->numHits : 0, missesBefore = cache ? cache->numMisses : 0;
+        result.numErrors = CheckFile(scanner, inputs->Nth(index), astInput, &diagnostics, cache,
+                                     measure ? &result.stats : NULL);
+        result.cacheHits = cache ? cache->numHits - hitsBefore : 0;
+        result.cacheMisses = cache ? cache->numMisses - missesBefore : 0;
+        std::string text = diagnostics.str();
+        result.textLength = text.size();
+        fflush(stdout);
+        if (!WriteAll(fd, (const char *)&result, sizeof(result)) ||
+            !WriteAll(fd, text.data(), text.size()))
+            break;
+    }
+    FreeScanner(scanner);
+}
+
+static int CheckFilesInParallel(List<const char*> *inputs, bool astInput, int numJobs,
+                                ResultCache *cache, UnitStats *stats)
+{
+    int numInputs = inputs->NumElements();
+    if (numJobs > numInputs) numJobs = numInputs;
+
+    volatile int *nextIndex = (volatile int *)mmap(NULL, sizeof(int), PROT_READ|PROT_WRITE,
+                                                   MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+    if (nextIndex == MAP_FAILED) Failure("Cannot set up worker pool: %s", strerror(errno));
+    *nextIndex = 0;
+
+    std::vector<pollfd> pipes;
+    std::vector<pid_t> workers;
+    fflush(stdout);
+    for (int w = 0; w < numJobs; w++) {
+        int fds[2];
+        if (pipe(fds) < 0) Failure("Cannot set up worker pool: %s", strerror(errno));
+        pid_t pid = fork();
+        if (pid < 0) Failure("Cannot set up worker pool: %s", strerror(errno));
+        if (pid == 0) {
+            close(fds[0]);
+            for (size_t p = 0; p < pipes.size(); p++) close(pipes[p].fd);
+            RunWorker(inputs, astInput, nextIndex, fds[1], cache, stats != NULL);
+            fflush(stdout);
+            _exit(0);
+        }
+        close(fds[1]);
+        pollfd pfd = { fds[0], POLLIN, 0 };
+        pipes.push_back(pfd);
+        workers.push_back(pid);
+    }
+
+    std::vector<std::string> received(numJobs);  // bytes read but not yet parsed
+    std::vector<std::string> texts(numInputs);
+    std::vector<int> errorCounts(numInputs, -1);  // -1 until the result arrives
+    int numOpen = numJobs, nextToPrint = 0, numFailed = 0;
+
+    while (numOpen > 0) {
+        if (poll(&pipes[0], pipes.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            Failure("Lost contact with workers: %s", strerror(errno));
+        }
+        for (int w = 0; w < numJobs; w++) {
+            if (pipes[w].fd < 0 || !(pipes[w].revents & (POLLIN|POLLHUP|POLLERR))) continue;
+            char chunk[65536];
+            ssize_t n = read(pipes[w].fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                close(pipes[w].fd);
+                pipes[w].fd = -1;
+                numOpen--;
+                continue;
+            }
+            std::string &buf = received[w];
+            buf.append(chunk, n);
+            UnitResult result;
+            while (buf.size() >= sizeof(result)) {
+                memcpy(&result, buf.data(), sizeof(result));
+                if (buf.size() < sizeof(result) + result.textLength) break;
+                texts[result.index] = buf.substr(sizeof(result), result.textLength);
+                errorCounts[result.index] = result.numErrors;
+                if (cache) {
+                    cache->numHits += result.cacheHits;
+                    cache->numMisses += result.cacheMisses;
+                }
+                if (stats) stats->Add(result.stats);
+                buf.erase(0, sizeof(result) + result.textLength);
+            }
+        }
+        for (; nextToPrint < numInputs && errorCounts[nextToPrint] >= 0; nextToPrint++) {
+            std::cerr << texts[nextToPrint];
+            if (numInputs > 1) PrintStatus(inputs->Nth(nextToPrint), errorCounts[nextToPrint]);
+            if (errorCounts[nextToPrint] > 0) numFailed++;
+            texts[nextToPrint].clear();
+        }
+    }
+
+    for (size_t w = 0; w < workers.size(); w++)
+        waitpid(workers[w], NULL, 0);
+    munmap((void *)nextIndex, sizeof(int));
+
+    // a worker that died mid-unit never reported it, or anything after it
+    for (; nextToPrint < numInputs; nextToPrint++) {
+        if (errorCounts[nextToPrint] < 0) {
+            std::cerr << inputs->Nth(nextToPrint) << ": checker terminated abnormally" << std::endl;
+            numFailed++;
+            continue;
+        }
+        std::cerr << texts[nextToPrint];
+        if (numInputs > 1) PrintStatus(inputs->Nth(nextToPrint), errorCounts[nextToPrint]);
+        if (errorCounts[nextToPrint] > 0) numFailed++;
+    }
+    return numFailed;
+}
+
+int CheckFiles(DriverOptions *options)
+{
+    ResultCache *cache = options->cacheDir ? new ResultCache(options->cacheDir) : NULL;
+    UnitStats *stats = (options->timeReport || options->memReport) ? new UnitStats : NULL;
+    int numFailed;
+    if (options->numJobs > 1 && options->inputs.NumElements() > 1)
+        numFailed = CheckFilesInParallel(&options->inputs, options->loadAst, options->numJobs,
+                                         cache, stats);
+    else
+        numFailed = CheckFilesSerially(&options->inputs, options->loadAst, cache, stats);
+    if (cache) {
+        cache->PrintStats();
+        delete cache;
+    }
+    if (stats) {
+        if (options->timeReport) stats->PrintTimes(std::cerr);
+        if (options->memReport) stats->PrintMemory(std::cerr);
+        delete stats;
+    }
+    return numFailed;
+}
+
+int EmitAst(DriverOptions *options)
+{
+    const char *fileName = options->inputs.NumElements() ? options->inputs.Nth(0) : NULL;
+    SourceBuffer *source = fileName ? SourceBuffer::Map(fileName) : SourceBuffer::Read(stdin);
+    yyscan_t scanner = NewScanner();
+    int numErrors;
+    {
+        Compilation unit(fileName, scanner, &std::cerr);
+        Compilation::SetCurrent(&unit);
+        if (!source) {
+            ReportUnreadable(fileName);
+        } else {
+            ParseUnit(&unit, source);
+            if (unit.program && unit.numErrors == 0 &&
+                !AstFile::Write(options->emitAst, unit.program, source))
+                ReportError::Formatted(NULL, "Cannot write AST file '%s'", options->emitAst);
+        }
+        Compilation::SetCurrent(NULL);
+        numErrors = unit.numErrors;
+    }
+    delete source;
+    FreeScanner(scanner);
+    return numErrors;
+}
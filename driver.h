@@ -0,0 +1,121 @@
+/* File: driver.h
+ * --------------
+ * The driver runs the front end (scanner, parser and semantic checker)
+ * over one or more translation units. A translation unit is a single
+ * Decaf source file, or standard input when no files are named on the
+ * command line. Scanner and error-reporting state is reset between
+ * units so that one process can check a whole batch of files.
+ *
+ * Usage:  dcc [-j N] [--threads N] [--cache DIR] [--time-report] [--mem-report] [file ... | @filelist ...] [-d <debug-key> ...]
+ *         dcc [-j N] [--threads N] [--time-report] [--mem-report] --load-ast file.dast ... [-d <debug-key> ...]
+ *         dcc --emit-ast out.dast [file] [-d <debug-key> ...]
+ *         dcc --server[=socket-path] [-d <debug-key> ...]
+ *         dcc --watch DIR [-d <debug-key> ...]
+ *
+ * A @filelist argument names a text file listing further inputs, one
+ * path per line (blank lines are ignored). With -j N the inputs are
+ * spread over N worker processes (N = 0 means one per online CPU); the
+ * output is the same as a serial run, in input order. With --threads N
+ * the declarations of each unit are checked on N threads (again 0 for
+ * one per online CPU), with the same output as one thread gives (see
+ * Program::Check). With --cache DIR, results for files whose contents
+ * were checked before by the same dcc build are replayed from the cache
+ * in DIR (see cache.h) and hit/miss counts are reported at the end.
+ * With --time-report, the time spent in each phase and a few counters,
+ * summed over all units, are reported at the end (see stats.h), and
+ * with --mem-report the memory taken by each class of AST node and by
+ * the tables beside the tree. With --emit-ast, the one input is parsed
+ * but not checked and its tree is written to an AST file, which
+ * --load-ast then checks in place of a source file without scanning or
+ * parsing it again (see astfile.h); AST files are not cached. With
+ * --server no files are read; see server.h. With --watch, see watch.h.
+ */
+
+#ifndef _H_driver
+#define _H_driver
+
+#include <string>
+#include "list.h"
+
+class Compilation;
+class SourceBuffer;
+
+
+/* Struct: DriverOptions
+ * ---------------------
+ * Settings collected from the command line.
+ */
+struct DriverOptions
+{
+    List<const char*> inputs;   // files to check, empty means stdin
+    int numJobs;                // number of workers, 1 checks serially
+    int numThreads;             // threads checking each unit, 1 for none extra
+    bool server;                // run as a compile server
+    const char *socketPath;     // server socket, NULL for stdin/stdout
+    const char *cacheDir;       // result cache directory, NULL for none
+    const char *watchDir;       // directory to watch, NULL for none
+    bool timeReport;            // report time per phase at the end
+    bool memReport;             // report memory per node class at the end
+    const char *emitAst;        // AST file to write, NULL to check as usual
+    bool loadAst;               // inputs are AST files rather than source
+
+    DriverOptions() : numJobs(1), numThreads(1), server(false), socketPath(NULL), cacheDir(NULL),
+                      watchDir(NULL), timeReport(false), memReport(false), emitAst(NULL), loadAst(false) {}
+};
+
+
+/* Function: ParseDriverCommandLine
+ * --------------------------------
+ * Fills in options from the command line, expanding any @filelist
+ * arguments into the input list. Everything from -d onwards is handed
+ * to ParseCommandLine to turn on debugging keys.
+ */
+void ParseDriverCommandLine(int argc, char *argv[], DriverOptions *options);
+
+
+/* Function: CheckFiles
+ * --------------------
+ * Checks every input (or stdin if there are none), serially or on a pool
+ * of worker processes as requested. When there is more than one input,
+ * each unit's diagnostics are followed by a status line naming the file
+ * and its error count. Returns the number of units that had errors.
+ */
+int CheckFiles(DriverOptions *options);
+
+
+/* Function: EmitAst
+ * ------------------
+ * Parses the one input (or stdin) and, if that produced no errors,
+ * writes its tree to the AST file named by options. Returns the number
+ * of errors reported.
+ */
+int EmitAst(DriverOptions *options);
+
+
+/* Function: CheckSource
+ * ---------------------
+ * Checks a program held in memory as the given unit, which names the
+ * scanner to use and where diagnostics go. The scanner works on the
+ * buffer in place, so its text may be left changed (see
+ * SourceBuffer). The unit's name is only used in debug output and may
+ * be NULL. Afterwards unit->program holds the tree, if parsing got that
+ * far. Returns the number of errors reported.
+ */
+int CheckSource(Compilation *unit, SourceBuffer *source);
+
+
+/* Function: ReadWholeFile
+ * -----------------------
+ * Reads the named file into contents. Returns false if it cannot be read.
+ */
+bool ReadWholeFile(const char *fileName, std::string *contents);
+
+
+/* Function: PrintStatus
+ * ---------------------
+ * Writes the line that closes a unit's diagnostics in a multi-file run:
+ * the file name and "ok" or its error count.
+ */
+void PrintStatus(const char *fileName, int numErrors);
+
+#endif
@@ -15,29 +15,51 @@ using namespace std;
 #include "ast_expr.h"
 #include "ast_stmt.h"
 #include "ast_decl.h"
+#include "compilation.h"
 
 
-int ReportError::numErrors = 0;
+int ReportError::NumErrors() {
+    return Compilation::Current()->numErrors;
+}
 
-void ReportError::UnderlineErrorInLine(const char *line, yyltype *pos) {
+void ReportError::UnderlineErrorInLine(ostream &out, int lineNum, int firstColumn, int lastColumn) {
+    int length;
+    const char *line = GetLineNumbered(Compilation::Current()->scanner, lineNum, &length);
     if (!line) return;
-    cerr << line << endl;
-    for (int i = 1; i <= pos->last_column; i++)
-        cerr << (i >= pos->first_column ? '^' : ' ');
-    cerr << endl;
+    out.write(line, length) << endl;
+    for (int i = 1; i <= lastColumn; i++)
+        out << (i >= firstColumn ? '^' : ' ');
+    out << endl;
 }
 
+/* Function: LineNumber
+ * --------------------
+ * The line of the current unit that loc starts on.
+ */
+static int LineNumber(yyltype *loc) {
+    int line, column;
+    GetLinePosition(Compilation::Current()->scanner, loc->offset, &line, &column);
+    return line;
+}
  
  
 void ReportError::OutputError(yyltype *loc, string msg) {
-    numErrors++;
+    Compilation *unit = Compilation::Current();
+    ostream &out = *unit->errors;
+    unit->numErrors++;
     fflush(stdout); // make sure any buffered text has been output
     if (loc) {
-        cerr << endl << "*** Error line " << loc->first_line << "." << endl;
-        UnderlineErrorInLine(GetLineNumbered(loc->first_line), loc);
+        // the underline runs to the column of the last byte covered,
+        // even when that is on a later line
+        int line, firstColumn, lastLine, lastColumn;
+        GetLinePosition(unit->scanner, loc->offset, &line, &firstColumn);
+        GetLinePosition(unit->scanner, loc->offset + (loc->length ? loc->length - 1 : 0),
+                        &lastLine, &lastColumn);
+        out << endl << "*** Error line " << line << "." << endl;
+        UnderlineErrorInLine(out, line, firstColumn, lastColumn);
     } else
-        cerr << endl << "*** Error." << endl;
-    cerr << "*** " << msg << endl << endl;
+        out << endl << "*** Error." << endl;
+    out << "*** " << msg << endl << endl;
 }
 
 
@@ -56,8 +78,13 @@ void ReportError::UntermComment() {
 }
 
 void ReportError::InvalidDirective(int linenum) {
-    yyltype ll = {0, linenum, 0, 0};
-    OutputError(&ll, "Invalid # directive");
+    Compilation *unit = Compilation::Current();
+    ostream &out = *unit->errors;
+    unit->numErrors++;
+    fflush(stdout);
+    out << endl << "*** Error line " << linenum << "." << endl;
+    UnderlineErrorInLine(out, linenum, 0, 0);
+    out << "*** Invalid # directive" << endl << endl;
 }
 
 void ReportError::LongIdentifier(yyltype *loc, const char *ident) {
@@ -81,7 +108,7 @@ void ReportError::UnrecogChar(yyltype *loc, char ch) {
 void ReportError::DeclConflict(Decl *decl, Decl *prevDecl) {
     ostringstream s;
     s << "Declaration of '" << decl << "' here conflicts with declaration on line " 
-      << prevDecl->GetLocation()->first_line;
+      << LineNumber(prevDecl->GetLocation());
     OutputError(decl->GetLocation(), s.str());
 }
   
@@ -183,11 +210,11 @@ void ReportError::BreakOutsideLoop(BreakStmt *bStmt) {
  * -------------------
  * Standard error-reporting function expected by yacc. Our version merely
  * just calls into the error reporter above, passing the location of
- * the last token read. If you want to suppress the ordinary "parse error"
- * message from yacc, you can implement yyerror to do nothing and
- * then call ReportError::Formatted yourself with a more descriptive 
- * message.
+ * the last token read, which the pure parser hands us as loc. If you
+ * want to suppress the ordinary "parse error" message from yacc, you
+ * can implement yyerror to do nothing and then call
+ * ReportError::Formatted yourself with a more descriptive message.
  */
-void yyerror(const char *msg) {
-    ReportError::Formatted(&yylloc, "%s", msg);
+void yyerror(yyltype *loc, yyscan_t scanner, Compilation *unit, const char *msg) {
+    ReportError::Formatted(loc, "%s", msg);
 }
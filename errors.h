@@ -13,6 +13,7 @@
 #define _H_errors
 
 #include <string>
+#include <iostream>
 using std::string;
 #include "location.h"
 class Type;
@@ -33,7 +34,7 @@ class Operator;
  * on this class are static, thus you can invoke methods directly via
  * the class name, e.g.
  *
- *    if (missingEnd) ReportError::UntermString(&yylloc, str);
+ *    if (missingEnd) ReportError::UntermString(yylloc, str);
  *
  * For some methods, the first argument is the pointer to the location
  * structure that identifies where the problem is (usually this is the
@@ -104,14 +105,14 @@ class ReportError
   static void Formatted(yyltype *loc, const char *format, ...);
 
 
-  // Returns number of error messages printed
-  static int NumErrors() { return numErrors; }
+  // Returns number of error messages printed for the current
+  // translation unit. Messages go to that unit's error stream.
+  static int NumErrors();
   
  private:
 
-  static void UnderlineErrorInLine(const char *line, yyltype *pos);
+  static void UnderlineErrorInLine(std::ostream &out, int lineNum, int firstColumn, int lastColumn);
   static void OutputError(yyltype *loc, string msg);
-  static int numErrors;
   
 };
 
@@ -0,0 +1,203 @@
+/* File: gendecaf.cc
+ * -----------------
+ * Generates synthetic Decaf programs for benchmarking dcc. The program is
+ * written to stdout and is built from repeated "modules", each holding
+ * an interface and a set of classes arranged in inheritance chains. Whole
+ * classes are added until the program reaches the requested size. Every choice comes from a seeded
+ * generator, so the same arguments always produce the same bytes.
+ *
+ * Usage:  gendecaf [-s seed] [-n classes] [-d depth] [-m methods]
+ *                  [-e nesting] [-b bytes] [-i invalid-percent]
+ *
+ *   -n  classes per module (default 8)
+ *   -d  inheritance depth: each class extends the one before it, except
+ *       every d-th, which starts a new chain (default 3)
+ *   -m  methods per class (default 4)
+ *   -e  nesting depth of the expressions in method bodies (default 4)
+ *   -b  total size to reach, with an optional K, M or G suffix (default 64K)
+ *   -i  percentage of methods given a deliberate semantic error (default 0)
+ *
+ * This is a stand-alone tool built by "make bench"; it is not part of dcc.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+
+
+/* Class: Random
+ * -------------
+ * splitmix64, chosen because its output is fixed by the algorithm alone
+ * and so is the same on every platform and library.
+ */
+class Random
+{
+  public:
+    Random(uint64_t seed) : state(seed) {}
+    uint64_t Next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    int Below(int n)        { return (int)(Next() % n); }
+    bool Percent(int pct)   { return Below(100) < pct; }
+
+  private:
+    uint64_t state;
+};
+
+struct Options
+{
+    uint64_t seed;
+    int numClasses, depth, numMethods, nesting, invalidPercent;
+    long long totalBytes;
+};
+
+static std::string out;       // text of the module being generated
+static long long numLines;
+
+
+static void Emit(const char *format, ...) __attribute__((format(printf, 1, 2)));
+static void Emit(const char *format, ...)
+{
+    char buf[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    out += buf;
+    for (const char *p = buf; *p; p++)
+        if (*p == '\n') numLines++;
+}
+
+/* Function: EmitExpr
+ * ------------------
+ * An int expression nested depth levels deep. Each level combines the
+ * deeper expression with one leaf, so the size grows linearly with depth.
+ */
+static void EmitExpr(Random *rng, int depth, const char *field)
+{
+    static const char *const ops[] = { "+", "-", "*", "/", "%" };
+    if (depth == 0) {
+        switch (rng->Below(4)) {
+          case 0: Emit("a"); break;
+          case 1: Emit("b"); break;
+          case 2: Emit("%s", field); break;
+          default: Emit("%d", rng->Below(1000)); break;
+        }
+        return;
+    }
+    Emit("(");
+    bool leafFirst = rng->Below(2);
+    if (leafFirst) { EmitExpr(rng, 0, field); Emit(" %s ", ops[rng->Below(5)]); }
+    EmitExpr(rng, depth - 1, field);
+    if (!leafFirst) { Emit(" %s ", ops[rng->Below(5)]); EmitExpr(rng, 0, field); }
+    Emit(")");
+}
+
+static void EmitMethod(Random *rng, const Options &opt, const char *cls, int m, bool invalid)
+{
+    char field[80];
+    snprintf(field, sizeof(field), "%s_f%d", cls, rng->Below(2));
+    Emit("  int %s_m%d(int a, int b) {\n", cls, m);
+    Emit("    int t;\n    int u;\n    bool c;\n");
+    if (invalid && rng->Below(2)) Emit("    int t;\n");        // duplicate declaration
+    Emit("    t = ");
+    EmitExpr(rng, opt.nesting, field);
+    Emit(";\n    u = ");
+    EmitExpr(rng, opt.nesting, field);
+    Emit(";\n");
+    if (invalid) Emit("    u = t + true;\n");                  // incompatible operands
+    Emit("    c = t < u;\n");
+    Emit("    while (c) {\n      t = t + 1;\n      c = t < u && a != b;\n    }\n");
+    Emit("    if (t >= u) {\n      Print(\"%s_m%d\", t);\n    } else {\n      u = u - 1;\n    }\n",
+         cls, m);
+    if (m > 0) Emit("    t = %s_m%d(u, t);\n", cls, m - 1);
+    Emit("    return t;\n  }\n");
+}
+
+/* Function: EmitClass
+ * -------------------
+ * Class i of module k. Modules group opt.numClasses classes under one
+ * interface, and everything is named with its module number so that
+ * modules never clash. The first class of a module also declares the
+ * module's interface.
+ */
+static void EmitClass(Random *rng, const Options &opt, int k, int i)
+{
+    char cls[64];
+    snprintf(cls, sizeof(cls), "C%d_%d", k, i);
+    if (i == 0)
+        Emit("interface I%d {\n  int visit%d(int x);\n}\n\n", k, k);
+    if (i % opt.depth == 0)
+        Emit("class %s implements I%d {\n", cls, k);
+    else
+        Emit("class %s extends C%d_%d {\n", cls, k, i - 1);
+    Emit("  int %s_f0;\n  int %s_f1;\n", cls, cls);
+    if (i % opt.depth == 0)
+        Emit("  int visit%d(int x) {\n    return x + %s_f0;\n  }\n", k, cls);
+    for (int m = 0; m < opt.numMethods; m++)
+        EmitMethod(rng, opt, cls, m, rng->Percent(opt.invalidPercent));
+    Emit("}\n\n");
+}
+
+static long long ParseSize(const char *arg)
+{
+    char *end;
+    long long n = strtoll(arg, &end, 10);
+    switch (*end) {
+      case 'k': case 'K': n <<= 10; break;
+      case 'm': case 'M': n <<= 20; break;
+      case 'g': case 'G': n <<= 30; break;
+    }
+    return n;
+}
+
+static void Usage()
+{
+    fprintf(stderr, "Usage:   gendecaf [-s seed] [-n classes] [-d depth] [-m methods]\n"
+                    "                  [-e nesting] [-b bytes] [-i invalid-percent]\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    Options opt = { 1, 8, 3, 4, 4, 0, 64 << 10 };
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= argc)
+            Usage();
+        const char *value = argv[++i];
+        switch (argv[i-1][1]) {
+          case 's': opt.seed = strtoull(value, NULL, 10); break;
+          case 'n': opt.numClasses = atoi(value); break;
+          case 'd': opt.depth = atoi(value); break;
+          case 'm': opt.numMethods = atoi(value); break;
+          case 'e': opt.nesting = atoi(value); break;
+          case 'b': opt.totalBytes = ParseSize(value); break;
+          case 'i': opt.invalidPercent = atoi(value); break;
+          default: Usage();
+        }
+    }
+    if (opt.numClasses < 1 || opt.depth < 1 || opt.numMethods < 0 || opt.nesting < 0)
+        Usage();
+
+    Random rng(opt.seed);
+    long long written = 0;
+    for (int c = 0; written < opt.totalBytes; c++) {
+        out.clear();
+        EmitClass(&rng, opt, c / opt.numClasses, c % opt.numClasses);
+        fwrite(out.data(), 1, out.size(), stdout);
+        written += out.size();
+    }
+    out.clear();
+    Emit("void main() {\n  C0_0 c;\n  c = New(C0_0);\n  Print(c.visit0(1));\n}\n");
+    fwrite(out.data(), 1, out.size(), stdout);
+    written += out.size();
+
+    fprintf(stderr, "gendecaf: %lld bytes, %lld lines\n", written, numLines);
+    return 0;
+}
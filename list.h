@@ -2,16 +2,22 @@
  * ------------
  * Simple list class for storing a linear collection of elements. It
  * supports operations similar in name to the CS107 DArray -- nth, insert,
- * append, remove, etc.  This class is nothing more than a very thin
- * cover of a STL deque, with some added range-checking. Given not everyone
- * is familiar with the C++ templates, this class provides a more familiar
- * interface.
+ * append, remove, etc.  The elements are kept in one contiguous array,
+ * with room for the first few inside the List itself, since most lists
+ * in a program (formals, actuals, members of small classes) are short.
+ * Only a list that outgrows that room allocates, so walking a list is a
+ * scan of consecutive memory. Given not everyone is familiar with the
+ * C++ templates, this class provides a more familiar interface.
  *
- * It can handle elements of any type, the typename for a List includes the
+ * It can handle elements of any type that can be copied byte for byte
+ * (numbers and pointers), the typename for a List includes the
  * element type in angle brackets, e.g.  to store elements of type double,
  * you would use the type name List<double>, to store elements of type
  * Decl *, it woud be List<Decl*> and so on.
  *
+ * Indexes are range-checked with Assert unless NDEBUG is defined, so
+ * that release builds leave the check out of their inner loops.
+ *
  * Here is some sample code illustrating the usage of a List of integers
  *
  *   int Sum(List<int> *list)
@@ -28,45 +34,102 @@
 #ifndef _H_list
 #define _H_list
 
-#include <deque>
+#include <string.h>
+#include <type_traits>
 #include "utility.h"  // for Assert()
+#include "arena.h"
+
+#ifdef NDEBUG
+#define ListAssert(expr)  ((void)0)
+#else
+#define ListAssert(expr)  Assert(expr)
+#endif
   
 class Node;
 
 template<class Element> class List {
 
  private:
-    std::deque<Element> elems;
+    static const int InlineCapacity = 4;
+
+    Element *elems;           // inlineElems until that fills, then the heap
+    int numElements, capacity;
+    Element inlineElems[InlineCapacity];
+
+    static_assert(std::is_trivially_copyable<Element>::value,
+                  "List elements are moved with memcpy");
+
+    List(const List &);             // not copyable
+    void operator=(const List &);
+
+    void Reserve(int needed) {
+        if (needed <= capacity) return;
+        int newCapacity = capacity * 2 > needed ? capacity * 2 : needed;
+        Element *storage = (Element *)(elems == inlineElems ?
+                malloc(newCapacity * sizeof(Element)) :
+                realloc(elems, newCapacity * sizeof(Element)));
+        if (!storage) Failure("Out of memory");
+        if (elems == inlineElems) {
+            memcpy(storage, inlineElems, numElements * sizeof(Element));
+            Arena *arena = CurrentArena();
+            if (arena && arena->Owns(this)) arena->OnRelease(Destroy, this);
+        }
+        elems = storage;
+        capacity = newCapacity;
+    }
 
  public:
            // Create a new empty list
-    List() {}
+    List() : elems(inlineElems), numElements(0), capacity(InlineCapacity) {}
+    ~List() { if (elems != inlineElems) free(elems); }
+
+           // Lists made with new while a compilation is current live in
+           // its arena. One that outgrows its inline room is destroyed when
+           // the arena is released, to free its storage; the rest are just
+           // dropped with the arena.
+    static void *operator new(size_t size)
+        { return AllocateInCurrentArena(size, NULL); }
+    static void operator delete(void *) {}
 
            // Returns count of elements currently in list
     int NumElements() const
-	{ return elems.size(); }
+	{ return numElements; }
 
           // Returns element at index in list. Indexing is 0-based.
           // Raises an assert if index is out of range.
     Element Nth(int index) const
-	{ Assert(index >= 0 && index < NumElements());
+	{ ListAssert(index >= 0 && index < numElements);
 	  return elems[index]; }
 
           // Inserts element at index, shuffling over others
           // Raises assert if index out of range
     void InsertAt(const Element &elem, int index)
-	{ Assert(index >= 0 && index <= NumElements());
-	  elems.insert(elems.begin() + index, elem); }
+	{ ListAssert(index >= 0 && index <= numElements);
+	  Reserve(numElements + 1);
+	  memmove(elems + index + 1, elems + index, (numElements - index) * sizeof(Element));
+	  elems[index] = elem;
+	  numElements++; }
 
           // Adds element to list end
     void Append(const Element &elem)
-	{ elems.push_back(elem); }
+	{ Reserve(numElements + 1);
+	  elems[numElements++] = elem; }
 
          // Removes element at index, shuffling down others
          // Raises assert if index out of range
     void RemoveAt(int index)
-	{ Assert(index >= 0 && index < NumElements());
-	  elems.erase(elems.begin() + index); }
+	{ ListAssert(index >= 0 && index < numElements);
+	  memmove(elems + index, elems + index + 1, (numElements - index - 1) * sizeof(Element));
+	  numElements--; }
+
+         // Removes all elements
+    void Clear()
+	{ numElements = 0; }
+
+         // Reverses the order of the elements
+    void Reverse()
+        { for (int i = 0, j = numElements - 1; i < j; i++, j--) {
+             Element tmp = elems[i]; elems[i] = elems[j]; elems[j] = tmp; } }
           
        // These are some specific methods useful for lists of ast nodes
        // They will only work on lists of elements that respond to the
@@ -77,6 +140,9 @@ template<class Element> class List {
         { for (int i = 0; i < NumElements(); i++)
              Nth(i)->SetParent(p); }
 
+ private:
+    static void Destroy(void *list)
+        { ((List *)list)->~List(); }
 };
 
 #endif
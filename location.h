@@ -2,9 +2,10 @@
  * ----------------
  * This file just contains features relative to the location structure
  * used to record the lexical position of a token or symbol.  This file
- * establishes the common definition for the yyltype structure, the global
- * variable yylloc, and a utility function to join locations you might
- * find handy at times.
+ * establishes the common definition for the yyltype structure and a
+ * utility function to join locations you might find handy at times.
+ * The parser is pure, so there is no global yylloc: the scanner fills in
+ * a location the parser hands it with each token.
  */
 
 #ifndef YYLTYPE
@@ -12,27 +13,21 @@
 /* Typedef: yyltype
  * ----------------
  * Defines the struct type that is used by the scanner to store
- * position information about each lexeme scanned.
+ * position information about each lexeme scanned. A location is just
+ * the range of bytes it covers in the source, which keeps it small
+ * enough to store inline in every AST node. Lines and columns are
+ * worked out from the offset only when an error is reported (see
+ * GetLinePosition in scanner.h).
  */
 typedef struct yyltype
 {
-    int timestamp;                 // you can ignore this field
-    int first_line, first_column;
-    int last_line, last_column;      
-    char *text;                    // you can also ignore this field
+    unsigned int offset;           // of the first byte, from the start of the source
+    unsigned int length;           // number of bytes covered
 } yyltype;
 
 #define YYLTYPE yyltype
 
 
-/* Global variable: yylloc
- * ------------------------
- * The global variable holding the position information about the
- * lexeme just scanned.
- */
-extern struct yyltype yylloc;
-
-
 /* Function: Join
  * --------------
  * Takes two locations and returns a new location which represents
@@ -41,10 +36,8 @@ extern struct yyltype yylloc;
 inline yyltype Join(yyltype first, yyltype last)
 {
   yyltype combined;
-  combined.first_column = first.first_column;
-  combined.first_line = first.first_line;
-  combined.last_column = last.last_column;
-  combined.last_line = last.last_line;
+  combined.offset = first.offset;
+  combined.length = last.offset + last.length - first.offset;
   return combined;
 }
 
@@ -56,4 +49,3 @@ inline yyltype Join(yyltype *firstPtr, yyltype *lastPtr)
 
 
 #endif
-
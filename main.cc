@@ -1,7 +1,7 @@
 /* File: main.cc
  * -------------
  * This file defines the main() routine for the program and not much else.
- * You should not need to modify this file.
+ * The work of checking each translation unit is done by the driver.
  */
  
 #include <string.h>
@@ -9,23 +9,38 @@
 #include "utility.h"
 #include "errors.h"
 #include "parser.h"
+#include "driver.h"
+#include "server.h"
+#include "watch.h"
+#include "compilation.h"
 
 
 /* Function: main()
  * ----------------
- * Entry point to the entire program.  We parse the command line and turn
- * on any debugging flags requested by the user when invoking the program.
- * InitScanner() is used to set up the scanner.
- * InitParser() is used to set up the parser. The call to yyparse() will
- * attempt to parse a complete program from the input. 
+ * Entry point to the entire program.  We parse the command line to collect
+ * the input files and turn on any debugging flags requested by the user
+ * when invoking the program. InitParser() is used to set up the parser.
+ * With no input files, a single program is read from stdin; otherwise each
+ * file is checked as a separate translation unit, serially or spread over
+ * worker processes with -j. The exit status is non-zero if any unit had
+ * errors. With --server, programs are instead taken from the requests
+ * of a compile server, and with --watch from a directory as its files
+ * change. With --emit-ast, the one input is only parsed, and its tree
+ * saved for a later --load-ast. With --threads, each unit's declarations
+ * are checked on that many threads.
  */
 int main(int argc, char *argv[])
 {
-    ParseCommandLine(argc, argv);
+    DriverOptions options;
+    ParseDriverCommandLine(argc, argv, &options);
+    Compilation::SetCheckThreads(options.numThreads);
   
-    InitScanner();
     InitParser();
-    yyparse();
-    return (ReportError::NumErrors() == 0? 0 : -1);
+    if (options.server)
+        return RunServer(options.socketPath);
+    if (options.watchDir)
+        return RunWatch(options.watchDir);
+    if (options.emitAst)
+        return (EmitAst(&options) == 0? 0 : -1);
+    return (CheckFiles(&options) == 0? 0 : -1);
 }
-
@@ -20,7 +20,7 @@
 
  
 // Next, we want to get the exported defines for the token codes and
-// typedef for YYSTYPE and exported global variable yylval.  These
+// typedef for YYSTYPE and the prototype for yylex.  These
 // definitions are generated and written to the y.tab.h header file. But
 // because that header does not have any protection against being
 // re-included and those definitions are also present in the y.tab.c,
@@ -28,11 +28,13 @@
 // we are compiling y.tab.c, which we use the YYBISON symbol for. 
 // Managing C headers can be such a mess! 
 
+class Compilation;              // the context passed to yyparse
+
 #ifndef YYBISON                 
 #include "y.tab.h"              
 #endif
 
-int yyparse();              // Defined in the generated y.tab.c file
-void InitParser();          // Defined in parser.y
+int yyparse(yyscan_t scanner, Compilation *unit); // Defined in the generated y.tab.c file
+void InitParser();                                // Defined in parser.y
 
 #endif
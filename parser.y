@@ -5,14 +5,47 @@
 
 %{
 
-#include "scanner.h" // for yylex
+#include "scanner.h" // for yyscan_t
 #include "parser.h"
 #include "errors.h"
-
-void yyerror(const char *msg); // standard error-handling routine
+#include "compilation.h"
+
+// standard error-handling routine, given the location of the bad token
+void yyerror(yyltype *loc, yyscan_t scanner, Compilation *unit, const char *msg);
+
+// A rule's location runs from the start of its first symbol to the end
+// of its last; an empty rule gets an empty range where it was reduced.
+#define YYLLOC_DEFAULT(Current, Rhs, N)                                 \
+    do {                                                                \
+        yyltype before = YYRHSLOC(Rhs, 0);                              \
+        if (N) {                                                        \
+            (Current) = Join(YYRHSLOC(Rhs, 1), YYRHSLOC(Rhs, N));       \
+        } else {                                                        \
+            (Current).offset = before.offset + before.length;           \
+            (Current).length = 0;                                       \
+        }                                                               \
+    } while (0)
 
 %}
 
+/* Pure parser
+ * -----------
+ * The parser keeps yylval and yylloc on its own stack rather than in
+ * globals and hands yylex pointers to them, so any number of parses can
+ * run at once. The scanner object to read tokens from is passed to
+ * yyparse and on to each call of yylex. The Compilation for the unit
+ * being parsed receives the finished Program; checking it is left to the
+ * caller so parsing and checking are separate steps.
+ */
+%define api.pure full
+%locations
+%param { yyscan_t scanner }
+%parse-param { Compilation *unit }
+
+%code provides {
+int yylex(YYSTYPE *yylval, YYLTYPE *yylloc, yyscan_t scanner); // Defined in lex.yy.c
+}
+
  
 /* yylval 
  * ------
@@ -22,7 +55,7 @@ void yyerror(const char *msg); // standard error-handling routine
     bool boolConstant;
     char *stringConstant;
     double doubleConstant;
-    char identifier[MaxIdentLen+1]; // +1 for terminating null
+    Symbol identifier;              // interned, see symtab.h
     Decl *decl;
     List<Decl*> *declList;
     Type *type;
@@ -99,10 +132,7 @@ void yyerror(const char *msg); // standard error-handling routine
  */
 Program   :    DeclList            { 
                                       @1; 
-                                      Program *program = new Program($1);
-                                      // if no errors, advance to next phase
-                                      if (ReportError::NumErrors() == 0) 
-                                           program->Check();
+                                      unit->program = new Program($1);
                                     }
           ;
 
@@ -187,14 +217,16 @@ FnDecl    :    FnHeader StmtBlock   { ($$=$1)->SetFunctionBody($2); }
           ;
 
 StmtBlock :    '{' VarDecls StmtList '}' 
-                                    { $$ = new StmtBlock($2, $3); }
+                                    { $3->Reverse(); $$ = new StmtBlock($2, $3); }
           ;
 
 VarDecls  :    VarDecls VarDecl     { ($$=$1)->Append($2); }
           |    /* empty */          { $$ = new List<VarDecl*>; }
           ;
 
-StmtList  :    Stmt StmtList        { $$ = $2; $$->InsertAt($1, 0); }
+  /* Built back to front, since appending is cheaper than inserting at
+   * the start; StmtBlock puts the statements back in order. */
+StmtList  :    Stmt StmtList        { ($$=$2)->Append($1); }
           |    /* empty */          { $$ = new List<Stmt*>; }
           ;
 
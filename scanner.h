@@ -3,23 +3,58 @@
  * You should not need to modify this file. It declare a few constants,
  * types, variables,and functions that are used and/or exported by
  * the lex-generated scanner.
+ *
+ * The scanner is reentrant: all of its state lives in a scanner object
+ * (a yyscan_t) rather than in globals, so several can be active at once
+ * and one can be reused for many translation units. yylex itself takes
+ * the token value and location to fill in, so it is declared in
+ * parser.h alongside YYSTYPE.
+ *
+ * The scanner reads straight out of a SourceBuffer (see source.h) and
+ * remembers where each line starts rather than copying the lines. Token
+ * locations are byte offsets; GetLinePosition turns one into the line
+ * and column an error message shows.
  */
 
 #ifndef _H_scanner
 #define _H_scanner
 
-#include <stdio.h>
+#include <string>
+#include "list.h"
+#include "source.h"
 
 #define MaxIdentLen 31    // Maximum length for identifiers
 
-extern char *yytext;      // Text of lexeme just scanned
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;   // Opaque handle to a scanner object
+#endif
+
+
+struct yy_buffer_state;
+
+
+/* Struct: ScannerState
+ * --------------------
+ * Our own per-scanner state, attached to the flex scanner object as its
+ * "extra" data. Flex keeps its buffer bookkeeping and the start-condition
+ * stack in the scanner object itself.
+ */
+struct ScannerState
+{
+    SourceBuffer *source;           // text being scanned
+    struct yy_buffer_state *buffer; // flex's handle on source
+    List<size_t> lineStarts;        // offset in source of each line
 
+    ScannerState() : source(NULL), buffer(NULL) {}
+};
 
-int yylex();              // Defined in the generated lex.yy.c file
-void yyrestart(FILE *fp); // ditto
 
+yyscan_t NewScanner();                          // Defined in scanner.l user subroutines
+void InitScanner(yyscan_t scanner, SourceBuffer *source); // ditto
+size_t LineIndexBytes(yyscan_t scanner);        // ditto
+void FreeScanner(yyscan_t scanner);             // ditto
+const char *GetLineNumbered(yyscan_t scanner, int n, int *length); // ditto
+void GetLinePosition(yyscan_t scanner, size_t offset, int *line, int *column); // ditto
 
-void InitScanner();                 // Defined in scanner.l user subroutines
-const char *GetLineNumbered(int n); // ditto
- 
 #endif
@@ -0,0 +1,144 @@
+/* File: server.cc
+ * ---------------
+ * Implementation of the compile server.
+ */
+
+#include "server.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sstream>
+#include <string>
+#include "utility.h"
+#include "scanner.h"
+#include "driver.h"
+#include "compilation.h"
+#include "source.h"
+
+
+/* Function: SendReply
+ * -------------------
+ * Writes one framed reply. Returns false if the client has gone away.
+ */
+static bool SendReply(FILE *out, int numErrors, const std::string &text)
+{
+    fprintf(out, "%d %zu\n", numErrors, text.size());
+    fwrite(text.data(), 1, text.size(), out);
+    return fflush(out) == 0;
+}
+
+/* Function: ServeRequest
+ * ----------------------
+ * Reads one request from in, checks it and writes the reply to out. The
+ * source buffer is kept by the caller so its storage is reused from one
+ * request to the next, and the scanner works on it in place, after the
+ * two NULs it needs. Returns false at end of input, on a malformed
+ * request or when the reply cannot be sent.
+ */
+static bool ServeRequest(yyscan_t scanner, FILE *in, FILE *out, std::string *source)
+{
+    char header[4096];
+    if (!fgets(header, sizeof(header), in)) return false;
+
+    char *name, *end;
+    long length = strtol(header, &name, 10);
+    if (name == header || length < 0 || length > INT_MAX ||
+        (*name != ' ' && *name != '\n') || !(end = strchr(name, '\n'))) {
+        SendReply(out, -1, "malformed request header\n");
+        return false;
+    }
+    *end = '\0';
+    while (*name == ' ') name++;
+
+    source->resize(length + 2);
+    if (length > 0 && fread(&(*source)[0], 1, length, in) != (size_t)length) {
+        SendReply(out, -1, "request truncated\n");
+        return false;
+    }
+    (*source)[length] = (*source)[length + 1] = '\0';
+
+    std::ostringstream diagnostics;
+    Compilation unit(*name ? name : NULL, scanner, &diagnostics);
+    SourceBuffer *buffer = SourceBuffer::Borrow(&(*source)[0], length);
+    int numErrors = CheckSource(&unit, buffer);
+    delete buffer;
+    return SendReply(out, numErrors, diagnostics.str());
+}
+
+/* Function: ServeSession
+ * ----------------------
+ * Serves requests from one client until it stops sending them.
+ */
+static void ServeSession(yyscan_t scanner, FILE *in, FILE *out)
+{
+    std::string source;
+    while (ServeRequest(scanner, in, out, &source))
+        ;
+}
+
+static int ServeStdio(yyscan_t scanner)
+{
+    // replies get the real stdout; stray output from the checker goes to stderr
+    fflush(stdout);
+    int replyFd = dup(STDOUT_FILENO);
+    FILE *out = replyFd < 0 ? NULL : fdopen(replyFd, "w");
+    if (!out || dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+        Failure("Cannot set up server output: %s", strerror(errno));
+    ServeSession(scanner, stdin, out);
+    fclose(out);
+    return 0;
+}
+
+static int ServeSocket(yyscan_t scanner, const char *socketPath)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "dcc: socket path '%s' is too long\n", socketPath);
+        return 2;
+    }
+    strcpy(addr.sun_path, socketPath);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath);
+    if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listener, 16) < 0) {
+        fprintf(stderr, "dcc: cannot listen on '%s': %s\n", socketPath, strerror(errno));
+        return 2;
+    }
+    PrintDebug("server", "Listening on %s", socketPath);
+
+    while (true) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "dcc: accept failed: %s\n", strerror(errno));
+            break;
+        }
+        int replyFd = dup(fd);
+        FILE *in = fdopen(fd, "r");
+        FILE *out = replyFd < 0 ? NULL : fdopen(replyFd, "w");
+        if (in && out) ServeSession(scanner, in, out);
+        if (in) fclose(in); else close(fd);
+        if (out) fclose(out); else if (replyFd >= 0) close(replyFd);
+    }
+    close(listener);
+    unlink(socketPath);
+    return 2;
+}
+
+int RunServer(const char *socketPath)
+{
+    signal(SIGPIPE, SIG_IGN);  // a client that hangs up must not kill the server
+    yyscan_t scanner = NewScanner();
+    int status = socketPath ? ServeSocket(scanner, socketPath) : ServeStdio(scanner);
+    FreeScanner(scanner);
+    return status;
+}
@@ -0,0 +1,35 @@
+/* File: server.h
+ * --------------
+ * The compile server keeps one warm dcc process checking programs sent
+ * to it, so that editors and hooks that check many small files do not
+ * pay for process start-up on every one. The scanner object and its
+ * buffers are set up once and reused for every request.
+ *
+ * Requests and replies are framed alike, as a header line followed by
+ * a body of exactly the number of bytes the header gives:
+ *
+ *     request:  <length> [<name>]\n<source text>
+ *     reply:    <error count> <length>\n<diagnostic text>
+ *
+ * The name is optional and only shows up in debug output. A malformed
+ * request gets a reply with an error count of -1 and a message as its
+ * text, and ends the session.
+ */
+
+#ifndef _H_server
+#define _H_server
+
+
+/* Function: RunServer
+ * -------------------
+ * Serves requests until told to stop. With a NULL socketPath, requests
+ * are read from stdin and replies written to stdout until end of input;
+ * anything else the checker prints goes to stderr so it cannot corrupt
+ * the replies. Otherwise the server listens on a Unix domain socket at
+ * socketPath (replacing any stale one) and serves one connection at a
+ * time, each for as many requests as the client sends. Returns the exit
+ * status for main.
+ */
+int RunServer(const char *socketPath);
+
+#endif
@@ -0,0 +1,31 @@
+/* File: sha256.h
+ * --------------
+ * A small self-contained SHA-256 (FIPS 180-4), used to name entries in
+ * the result cache by the content they were computed from. Data can be
+ * fed in pieces with Update; Finish returns the digest as 64 lowercase
+ * hex digits.
+ */
+
+#ifndef _H_sha256
+#define _H_sha256
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+
+class Sha256
+{
+  public:
+    Sha256();
+    void Update(const void *data, size_t length);
+    std::string Finish();    // object must not be updated afterwards
+
+  private:
+    uint32_t state[8];
+    uint64_t numBytes;        // total fed in so far
+    unsigned char block[64];  // partial block not yet compressed
+    void Compress(const unsigned char *chunk);
+};
+
+#endif
@@ -0,0 +1,97 @@
+/* File: source.cc
+ * ---------------
+ * Implementation of source buffers.
+ */
+
+#include "source.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+SourceBuffer::SourceBuffer(char *d, size_t len, size_t mapped, bool own) {
+    data = d;
+    length = len;
+    mappedSize = mapped;
+    owned = own;
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (!owned)
+        return;
+    if (mappedSize > 0)
+        munmap(data, mappedSize);
+    else
+        free(data);
+}
+
+/* Function: Map
+ * -------------
+ * Reserves zero-filled anonymous memory large enough for the file and
+ * its two NULs, then maps the file over the start of it. Whatever the
+ * file's size, the bytes after its end are zeros from one mapping or the
+ * other, so the NULs never have to be written.
+ */
+SourceBuffer *SourceBuffer::Map(const char *fileName) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return NULL;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        FILE *fp = fdopen(fd, "rb");
+        SourceBuffer *source = fp ? Read(fp) : NULL;
+        if (fp) fclose(fp); else close(fd);
+        return source;
+    }
+
+    size_t length = info.st_size, pageSize = sysconf(_SC_PAGESIZE);
+    size_t mappedSize = (length + 2 + pageSize - 1) / pageSize * pageSize;
+    void *base = mmap(NULL, mappedSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (base != MAP_FAILED && length > 0 &&
+        mmap(base, length, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mappedSize);
+        base = MAP_FAILED;
+    }
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+    madvise(base, mappedSize, MADV_SEQUENTIAL);
+    return new SourceBuffer((char *)base, length, mappedSize, true);
+}
+
+SourceBuffer *SourceBuffer::Read(FILE *fp) {
+    size_t length = 0, capacity = 65536;
+    char *data = (char *)malloc(capacity);
+    size_t n;
+    while (data && (n = fread(data + length, 1, capacity - 2 - length, fp)) > 0) {
+        length += n;
+        if (capacity - 2 - length == 0) {
+            char *bigger = (char *)realloc(data, capacity *= 2);
+            if (!bigger) free(data);
+            data = bigger;
+        }
+    }
+    if (!data || ferror(fp)) {
+        free(data);
+        return NULL;
+    }
+    data[length] = data[length + 1] = '\0';
+    return new SourceBuffer(data, length, 0, true);
+}
+
+SourceBuffer *SourceBuffer::Copy(const char *text, size_t length) {
+    char *data = (char *)malloc(length + 2);
+    if (!data) return NULL;
+    memcpy(data, text, length);
+    data[length] = data[length + 1] = '\0';
+    return new SourceBuffer(data, length, 0, true);
+}
+
+SourceBuffer *SourceBuffer::Borrow(char *text, size_t length) {
+    return new SourceBuffer(text, length, 0, false);
+}
@@ -0,0 +1,48 @@
+/* File: source.h
+ * --------------
+ * A SourceBuffer holds the complete text of one translation unit in
+ * memory, laid out the way flex's yy_scan_buffer wants it: the text
+ * followed by two NUL bytes. The scanner works directly on this memory
+ * and error reporting reads source lines back out of it, so the text is
+ * never copied once it is loaded.
+ *
+ * Regular files are memory-mapped rather than read. The mapping is
+ * private and writable because flex temporarily overwrites the byte
+ * after each token; the kernel copies just the pages that touches, and
+ * the file itself is never modified. Anything that cannot be mapped
+ * (stdin, pipes) is read into an ordinary heap buffer instead.
+ */
+
+#ifndef _H_source
+#define _H_source
+
+#include <stddef.h>
+#include <stdio.h>
+
+
+class SourceBuffer
+{
+  public:
+        // Each returns NULL if the source cannot be opened or read
+    static SourceBuffer *Map(const char *fileName);
+    static SourceBuffer *Read(FILE *fp);                  // reads to end of fp
+    static SourceBuffer *Copy(const char *text, size_t length);
+
+        // Uses text in place; it must be followed by two NULs and
+        // outlive the buffer, which never frees it
+    static SourceBuffer *Borrow(char *text, size_t length);
+    ~SourceBuffer();
+
+    char *Data()      { return data; }
+    size_t Length()   { return length; }   // not counting the two NULs
+
+  private:
+    char *data;
+    size_t length;
+    size_t mappedSize;   // bytes to munmap, 0 if data is from malloc
+    bool owned;          // false if data belongs to someone else
+
+    SourceBuffer(char *data, size_t length, size_t mappedSize, bool owned);
+};
+
+#endif
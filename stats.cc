@@ -0,0 +1,151 @@
+/* File: stats.cc
+ * --------------
+ * Implementation of the --time-report and --mem-report measurements.
+ */
+
+#include "stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include "ast.h"
+
+static const char *const phaseNames[NumPhases] = { "scan", "parse", "scope", "check" };
+
+
+UnitStats::UnitStats() {
+    memset(this, 0, sizeof(*this));
+}
+
+void UnitStats::Add(const UnitStats &other) {
+    for (int p = 0; p < NumPhases; p++) {
+        wallSeconds[p] += other.wallSeconds[p];
+        cpuSeconds[p] += other.cpuSeconds[p];
+    }
+    numUnits += other.numUnits;
+    numTokens += other.numTokens;
+    numNodes += other.numNodes;
+    numLookups += other.numLookups;
+    numScopesProbed += other.numScopesProbed;
+    numDiagnostics += other.numDiagnostics;
+    for (int k = 0; k < MaxNodeKinds; k++) {
+        nodeCounts[k] += other.nodeCounts[k];
+        scopeBytes[k] += other.scopeBytes[k];
+    }
+    stringBytes += other.stringBytes;
+    numSymbols += other.numSymbols;
+    symbolBytes += other.symbolBytes;
+    lineIndexBytes += other.lineIndexBytes;
+    numTypes += other.numTypes;
+    typeBytes += other.typeBytes;
+    arenaBytes += other.arenaBytes;
+}
+
+/* Function: PeakResidentKB
+ * ------------------------
+ * The high-water mark of this process or any -j worker, in kilobytes.
+ */
+static long PeakResidentKB() {
+    struct rusage self, workers;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &workers);
+    return self.ru_maxrss > workers.ru_maxrss ? self.ru_maxrss : workers.ru_maxrss;
+}
+
+void UnitStats::SeparateScanFromParse() {
+    double parseWall = wallSeconds[PhaseParse];
+    double share = parseWall > 0 ? wallSeconds[PhaseScan] / parseWall : 0;
+    if (share > 1) share = 1;
+    cpuSeconds[PhaseScan] = cpuSeconds[PhaseParse] * share;
+    cpuSeconds[PhaseParse] -= cpuSeconds[PhaseScan];
+    wallSeconds[PhaseParse] -= wallSeconds[PhaseScan];
+}
+
+void UnitStats::PrintTimes(std::ostream &out) {
+    char line[128];
+    double totalWall = 0, totalCpu = 0;
+    out << "dcc time report, " << numUnits << (numUnits == 1 ? " unit" : " units") << std::endl;
+    sprintf(line, "  %-10s %12s %12s", "phase", "wall ms", "cpu ms");
+    out << line << std::endl;
+    for (int p = 0; p < NumPhases; p++) {
+        sprintf(line, "  %-10s %12.3f %12.3f", phaseNames[p],
+                wallSeconds[p] * 1e3, cpuSeconds[p] * 1e3);
+        out << line << std::endl;
+        totalWall += wallSeconds[p];
+        totalCpu += cpuSeconds[p];
+    }
+    sprintf(line, "  %-10s %12.3f %12.3f", "total", totalWall * 1e3, totalCpu * 1e3);
+    out << line << std::endl;
+
+    struct { const char *name; long count; } counters[] = {
+        { "tokens scanned", numTokens },
+        { "AST nodes allocated", numNodes },
+        { "FindDecl lookups", numLookups },
+        { "scopes probed", numScopesProbed },
+        { "diagnostics", numDiagnostics },
+    };
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+        sprintf(line, "  %-22s %12ld", counters[i].name, counters[i].count);
+        out << line << std::endl;
+    }
+    sprintf(line, "  %-22s %12ld", "peak RSS (KB)", PeakResidentKB());
+    out << line << std::endl;
+}
+
+// Orders node kinds by the bytes they take, most first
+struct MoreBytes
+{
+    const long *bytes;
+    MoreBytes(const long *b) : bytes(b) {}
+    bool operator()(int a, int b) const { return bytes[a] > bytes[b]; }
+};
+
+/* Function: PrintMemory
+ * ---------------------
+ * One row per node class that was allocated, largest first, giving the
+ * bytes of its instances plus those of the scope tables they own, then
+ * the other tables, the arenas' total and the peak resident set size.
+ */
+void UnitStats::PrintMemory(std::ostream &out) {
+    char line[128];
+    std::vector<int> kinds;
+    long nodeBytes[MaxNodeKinds], totalNodes = 0, totalBytes = 0;
+    for (int k = 0; k < NumNodeKinds; k++) {
+        nodeBytes[k] = nodeCounts[k] * NodeKindSize((NodeKind)k) + scopeBytes[k];
+        if (nodeCounts[k] == 0) continue;
+        kinds.push_back(k);
+        totalNodes += nodeCounts[k];
+        totalBytes += nodeBytes[k];
+    }
+    std::stable_sort(kinds.begin(), kinds.end(), MoreBytes(nodeBytes));
+
+    out << "dcc memory report, " << numUnits << (numUnits == 1 ? " unit" : " units") << std::endl;
+    sprintf(line, "  %-22s %12s %12s %12s", "node class", "count", "bytes", "scope bytes");
+    out << line << std::endl;
+    for (size_t i = 0; i < kinds.size(); i++) {
+        int k = kinds[i];
+        sprintf(line, "  %-22s %12ld %12ld %12ld", NodeKindName((NodeKind)k),
+                nodeCounts[k], nodeBytes[k], scopeBytes[k]);
+        out << line << std::endl;
+    }
+    sprintf(line, "  %-22s %12ld %12ld", "all nodes", totalNodes, totalBytes);
+    out << line << std::endl;
+
+    struct { const char *name; long count, bytes; } tables[] = {
+        { "identifiers", numSymbols, symbolBytes },
+        { "string constants", -1, stringBytes },
+        { "line index", -1, lineIndexBytes },
+        { "types made in checking", numTypes, typeBytes },
+    };
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+        if (tables[i].count < 0)
+            sprintf(line, "  %-22s %12s %12ld", tables[i].name, "", tables[i].bytes);
+        else
+            sprintf(line, "  %-22s %12ld %12ld", tables[i].name, tables[i].count, tables[i].bytes);
+        out << line << std::endl;
+    }
+    sprintf(line, "  %-22s %12s %12ld", "arena total", "", arenaBytes);
+    out << line << std::endl;
+    sprintf(line, "  %-22s %12ld", "peak RSS (KB)", PeakResidentKB());
+    out << line << std::endl;
+}
@@ -0,0 +1,120 @@
+/* File: stats.h
+ * -------------
+ * Timing and counters for --time-report, and the memory accounting for
+ * --mem-report. Each compilation being measured points at a UnitStats
+ * that the phases add into; when the report is off that pointer is NULL
+ * and every probe below is a single test of it.
+ *
+ * Scanning happens inside the parse, one token at a time, so only its
+ * wall time is measured directly (from the monotonic clock, which is
+ * cheap to read). Its CPU time is estimated as the same share of the
+ * parse's CPU time as its wall time was of the parse's wall time; the
+ * parse row then shows the remainder. The report ends with the peak
+ * resident set size of the run.
+ *
+ * The memory report counts the nodes of each class as they are made and
+ * measures the rest once a unit has been checked: the scope and class
+ * member tables (an estimate from their bucket and entry counts, as the
+ * standard library does not say what it allocates), the strings, the
+ * identifier table, the line index and the types made while checking,
+ * which are nodes too and so are also counted in their classes' rows.
+ */
+
+#ifndef _H_stats
+#define _H_stats
+
+#include <stddef.h>
+#include <time.h>
+#include <iostream>
+
+
+enum Phase { PhaseScan, PhaseParse, PhaseScope, PhaseCheck, NumPhases };
+
+const int MaxNodeKinds = 64;    // room for every NodeKind (see ast.h)
+
+
+/* Struct: UnitStats
+ * -----------------
+ * Measurements for one translation unit, or the sum over many. It is
+ * plain data so it can be sent between processes as raw bytes.
+ */
+struct UnitStats
+{
+    double wallSeconds[NumPhases], cpuSeconds[NumPhases];
+    long numUnits;
+    long numTokens;        // tokens handed to the parser
+    long numNodes;         // AST nodes allocated
+    long numLookups;       // calls to Node::FindDecl
+    long numScopesProbed;  // scopes searched by those calls
+    long numDiagnostics;
+
+    long nodeCounts[MaxNodeKinds];  // nodes allocated, by NodeKind
+    long scopeBytes[MaxNodeKinds];  // their scope and member tables, by NodeKind
+    long stringBytes;      // string constants
+    long numSymbols, symbolBytes;   // the identifier table and names
+    long lineIndexBytes;   // where each source line starts
+    long numTypes, typeBytes;       // types made while checking
+    long arenaBytes;       // everything allocated from the arenas
+
+    UnitStats();
+    void Add(const UnitStats &other);
+
+        // Moves the scan time measured during a parse out of the parse row
+    void SeparateScanFromParse();
+
+        // Write the --time-report and --mem-report reports to out
+    void PrintTimes(std::ostream &out);
+    void PrintMemory(std::ostream &out);
+};
+
+
+/* Function: HashMapBytes
+ * ----------------------
+ * An estimate of the memory an unordered_map takes: its bucket array
+ * and one node per entry holding the value and the link to the next.
+ */
+template <class Map> size_t HashMapBytes(const Map &map) {
+    return map.bucket_count() * sizeof(void *) +
+           map.size() * (sizeof(void *) + sizeof(typename Map::value_type));
+}
+
+inline double WallClock() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+inline double CpuClock() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+/* Class: PhaseTimer
+ * -----------------
+ * Adds the wall and CPU time from its construction to its destruction
+ * to one phase of stats, or does nothing if stats is NULL.
+ *
+ *     { PhaseTimer timer(unit->stats, PhaseCheck);  ... }
+ */
+class PhaseTimer
+{
+  public:
+    PhaseTimer(UnitStats *s, Phase p) : stats(s), phase(p) {
+        if (stats) { wallStart = WallClock(); cpuStart = CpuClock(); }
+    }
+    ~PhaseTimer() {
+        if (stats) {
+            stats->wallSeconds[phase] += WallClock() - wallStart;
+            stats->cpuSeconds[phase] += CpuClock() - cpuStart;
+        }
+    }
+
+  private:
+    UnitStats *stats;
+    Phase phase;
+    double wallStart, cpuStart;
+};
+
+#endif
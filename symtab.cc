@@ -0,0 +1,69 @@
+/* File: symtab.cc
+ * ---------------
+ * Implementation of the identifier table.
+ */
+
+#include "symtab.h"
+#include <string.h>
+#include "arena.h"
+
+static const int InitialSlots = 1024;   // a power of two
+
+
+static unsigned int Hash(const char *text, size_t length)
+{
+    unsigned int h = 2166136261u;         // FNV-1a
+    for (size_t i = 0; i < length; i++)
+        h = (h ^ (unsigned char)text[i]) * 16777619u;
+    return h;
+}
+
+
+SymbolTable::SymbolTable(Arena *a) : arena(a), slots(InitialSlots, -1) {}
+
+Symbol SymbolTable::Intern(const char *text, size_t length) {
+    unsigned int hash = Hash(text, length);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Symbol s = slots[i];
+        if (s < 0) {
+            char *name = (char *)arena->Allocate(length + 1);
+            memcpy(name, text, length);
+            name[length] = '\0';
+            Entry e = { name, length, hash };
+            slots[i] = entries.size();
+            entries.push_back(e);
+            if (entries.size() * 2 > slots.size()) Grow();
+            return entries.size() - 1;
+        }
+        const Entry &e = entries[s];
+        if (e.hash == hash && e.length == length && memcmp(e.name, text, length) == 0)
+            return s;
+    }
+}
+
+Symbol SymbolTable::Intern(const char *name) {
+    return Intern(name, strlen(name));
+}
+
+size_t SymbolTable::BytesUsed() {
+    size_t bytes = entries.capacity() * sizeof(Entry) + slots.capacity() * sizeof(Symbol);
+    for (size_t s = 0; s < entries.size(); s++)
+        bytes += entries[s].length + 1;
+    return bytes;
+}
+
+/* Function: Grow
+ * --------------
+ * Doubles the slots once the table is half full, which keeps probe
+ * sequences short.
+ */
+void SymbolTable::Grow() {
+    slots.assign(slots.size() * 2, -1);
+    size_t mask = slots.size() - 1;
+    for (size_t s = 0; s < entries.size(); s++) {
+        size_t i = entries[s].hash & mask;
+        while (slots[i] >= 0) i = (i + 1) & mask;
+        slots[i] = s;
+    }
+}
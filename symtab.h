@@ -0,0 +1,51 @@
+/* File: symtab.h
+ * --------------
+ * A SymbolTable interns identifiers: the scanner hands it the text of
+ * each identifier and gets back a small integer, the same one every time
+ * the same name appears. The rest of the compiler works with these
+ * Symbols, so scopes are keyed by integers and comparing two names is a
+ * single compare. The text of each name is kept once, in the
+ * compilation's arena, for printing.
+ *
+ * Each compilation has its own table, so units checked at the same time
+ * do not share one and a unit's symbols go away with it.
+ */
+
+#ifndef _H_symtab
+#define _H_symtab
+
+#include <stddef.h>
+#include <vector>
+
+class Arena;
+
+typedef int Symbol;     // index into the table, from 0
+
+
+class SymbolTable
+{
+  public:
+    SymbolTable(Arena *arena);
+
+        // The symbol for the length bytes at text, adding it if new
+    Symbol Intern(const char *text, size_t length);
+    Symbol Intern(const char *name);
+
+        // Its text, NUL-terminated, valid as long as the arena
+    const char *Name(Symbol s)  { return entries[s].name; }
+    int NumSymbols()            { return entries.size(); }
+
+        // Memory taken by the table and the names, for --mem-report
+    size_t BytesUsed();
+
+  private:
+    struct Entry { const char *name; size_t length; unsigned int hash; };
+
+    Arena *arena;
+    std::vector<Entry> entries;   // indexed by symbol
+    std::vector<Symbol> slots;    // open-addressed hash of entries, -1 if free
+
+    void Grow();
+};
+
+#endif
@@ -20,3 +20,92 @@ for file in $dir/*.decaf; do
   fi
   rm $dir/$base.tmp
 done
+
+# a file checked twice is replayed from the cache the second time, even
+# when it has a syntax error (the scanner leaves a NUL in the source then)
+cache=$(mktemp -d)
+./dcc --cache $cache $dir/syntax.decaf >& /dev/null
+if ./dcc --cache $cache $dir/syntax.decaf 2>&1 | grep -q "cache: 1 hit, 0 misses"; then
+  echo "${green}cache: Unchanged file hits on the second run${reset}"
+else
+  echo "${red}cache: ERROR: Unchanged file missed on the second run${reset}"
+fi
+rm -rf $cache
+
+# the samples with expected output, in the order the shell lists them
+samples=$(ls $dir/*.decaf | while read file; do [ -f ${file%.decaf}.out ] && echo $file; done)
+
+# checking with several threads gives the diagnostics in source order,
+# the same as with one
+for threads in 1 4 0; do
+  failed=""
+  for file in $samples; do
+    base=$(basename $file .decaf)
+    ./dcc --threads $threads < $file >& $dir/$base.tmp
+    diff -q $dir/$base.tmp $dir/$base.out > /dev/null || failed="$failed $base"
+    rm $dir/$base.tmp
+  done
+  if [ -z "$failed" ]; then
+    echo "${green}threads $threads: Output matches expected result${reset}"
+  else
+    echo "${red}threads $threads: ERROR: Output does not match expected result for$failed${reset}"
+  fi
+done
+
+# -j prints each file's diagnostics in input order, each followed by
+# its status line, and fails just as a serial run does
+./dcc $samples >& /dev/null
+serial=$?
+./dcc -j 4 $samples >& $dir/jobs.tmp
+jobs=$?
+for file in $samples; do cat ${file%.decaf}.out; done > $dir/jobs.expected
+if grep -v "^$dir/[^ ]*\.decaf: \(ok\|[0-9]* errors\?\)$" $dir/jobs.tmp | diff -q - $dir/jobs.expected > /dev/null; then
+  echo "${green}-j 4: Output matches expected result${reset}"
+else
+  echo "${red}-j 4: ERROR: Output does not match expected result${reset}"
+fi
+if [ $jobs -ne $serial ]; then
+  echo "${red}-j 4: ERROR: Exit status $jobs, but $serial from a serial run${reset}"
+fi
+rm $dir/jobs.tmp $dir/jobs.expected
+
+# a tree saved with --emit-ast checks the same when loaded; a file that
+# does not parse is reported by --emit-ast itself
+failed=""
+ast=$(mktemp)
+for file in $samples; do
+  base=$(basename $file .decaf)
+  if ./dcc --emit-ast $ast $file >& $dir/$base.tmp; then
+    ./dcc --load-ast $ast >& $dir/$base.tmp
+  fi
+  diff -q $dir/$base.tmp $dir/$base.out > /dev/null || failed="$failed $base"
+  rm $dir/$base.tmp
+done
+if [ -z "$failed" ]; then
+  echo "${green}AST files: Output matches expected result${reset}"
+else
+  echo "${red}AST files: ERROR: Output does not match expected result for$failed${reset}"
+fi
+
+# a truncated AST file is rejected rather than loaded
+./dcc --emit-ast $ast $dir/matrix.decaf >& /dev/null
+head -c $(($(wc -c < $ast) / 2)) $ast > $ast.cut
+if ! ./dcc --load-ast $ast.cut 2>&1 | grep -q "Cannot read AST file"; then
+  echo "${red}AST files: ERROR: Truncated file was not rejected${reset}"
+else
+  echo "${green}AST files: Truncated file is rejected${reset}"
+fi
+rm -f $ast $ast.cut
+
+# the server answers each framed request with the error count and the
+# diagnostics a batch run prints
+request() { echo "$(wc -c < $1) $1"; cat $1; }
+(request $dir/t1.decaf; request $dir/bad1.decaf) | ./dcc --server > $dir/server.tmp 2> /dev/null
+(echo "0 $(wc -c < $dir/t1.out)"; cat $dir/t1.out;
+ echo "1 $(wc -c < $dir/bad1.out)"; cat $dir/bad1.out) > $dir/server.expected
+if diff -q $dir/server.tmp $dir/server.expected > /dev/null; then
+  echo "${green}server: Replies match expected result${reset}"
+else
+  echo "${red}server: ERROR: Replies do not match expected result${reset}"
+fi
+rm $dir/server.tmp $dir/server.expected
@@ -0,0 +1,194 @@
+/* File: watch.cc
+ * --------------
+ * Implementation of watch mode.
+ */
+
+#include "watch.h"
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <set>
+#include "utility.h"
+#include "scanner.h"
+#include "driver.h"
+#include "compilation.h"
+#include "source.h"
+
+// after the first event, wait this long for the rest of a burst (an
+// editor saving one file can produce several events)
+static const int SettleMillis = 50;
+
+static const uint32_t WatchEvents = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                    IN_CREATE | IN_DELETE;
+
+
+/* Struct: WatchedFile
+ * -------------------
+ * What we remember about a file between checks.
+ */
+struct WatchedFile
+{
+    std::string source;        // contents as last checked
+    int numErrors;
+    std::string diagnostics;
+};
+
+struct WatchState
+{
+    int inotifyFd;
+    yyscan_t scanner;
+    std::map<int, std::string> dirs;          // watch descriptor -> directory path
+    std::map<std::string, WatchedFile> files;
+};
+
+
+static bool IsDecafFile(const std::string &path)
+{
+    static const std::string suffix = ".decaf";
+    return path.size() > suffix.size() &&
+           path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/* Function: AddDirectory
+ * ----------------------
+ * Starts watching path and, recursively, its subdirectories, adding
+ * every Decaf file found to found.
+ */
+static void AddDirectory(WatchState *w, const std::string &path, std::set<std::string> *found)
+{
+    int wd = inotify_add_watch(w->inotifyFd, path.c_str(), WatchEvents);
+    if (wd < 0) {
+        std::cerr << "dcc: cannot watch '" << path << "': " << strerror(errno) << std::endl;
+        return;
+    }
+    w->dirs[wd] = path;
+    DIR *dir = opendir(path.c_str());
+    if (!dir) return;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;   // ., .. and hidden files
+        std::string child = path + "/" + entry->d_name;
+        struct stat info;
+        if (stat(child.c_str(), &info) < 0) continue;
+        if (S_ISDIR(info.st_mode))
+            AddDirectory(w, child, found);
+        else if (S_ISREG(info.st_mode) && IsDecafFile(child))
+            found->insert(child);
+    }
+    closedir(dir);
+}
+
+/* Function: Recheck
+ * -----------------
+ * Brings our record of path up to date: checks it if its contents are
+ * new or have changed, or drops it if it can no longer be read.
+ */
+static void Recheck(WatchState *w, const std::string &path)
+{
+    std::string source;
+    std::map<std::string, WatchedFile>::iterator known = w->files.find(path);
+    if (!ReadWholeFile(path.c_str(), &source)) {
+        if (known != w->files.end()) {
+            w->files.erase(known);
+            std::cerr << path << ": removed" << std::endl;
+        }
+        return;
+    }
+    if (known != w->files.end() && known->second.source == source)
+        return;   // touched but not changed
+
+    std::ostringstream diagnostics;
+    Compilation unit(path.c_str(), w->scanner, &diagnostics);
+    // checked in a copy, since scanning can leave the text changed and
+    // source is what the next read is compared with
+    SourceBuffer *buffer = SourceBuffer::Copy(source.data(), source.size());
+    if (!buffer) Failure("Cannot allocate source buffer");
+    CheckSource(&unit, buffer);
+    delete buffer;
+
+    WatchedFile &file = w->files[path];
+    file.source.swap(source);
+    file.numErrors = unit.numErrors;
+    file.diagnostics = diagnostics.str();
+    std::cerr << file.diagnostics;
+    PrintStatus(path.c_str(), file.numErrors);
+}
+
+/* Function: ReadEvents
+ * --------------------
+ * Reads a batch of inotify events, adding the paths of affected Decaf
+ * files to changed and watching any new directories. Returns false if
+ * the inotify descriptor fails.
+ */
+static bool ReadEvents(WatchState *w, std::set<std::string> *changed)
+{
+    char buffer[65536] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t length = read(w->inotifyFd, buffer, sizeof(buffer));
+    if (length < 0) return errno == EINTR;
+    for (char *p = buffer; p < buffer + length; ) {
+        struct inotify_event *event = (struct inotify_event *)p;
+        p += sizeof(struct inotify_event) + event->len;
+        if (event->mask & IN_IGNORED) {
+            w->dirs.erase(event->wd);
+            continue;
+        }
+        if (event->mask & IN_Q_OVERFLOW) {
+            // lost track, so recheck everything we know of
+            for (std::map<std::string, WatchedFile>::iterator i = w->files.begin(); i != w->files.end(); ++i)
+                changed->insert(i->first);
+            continue;
+        }
+        std::map<int, std::string>::iterator dir = w->dirs.find(event->wd);
+        if (dir == w->dirs.end() || event->len == 0) continue;
+        std::string path = dir->second + "/" + event->name;
+        if (event->mask & IN_ISDIR) {
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                AddDirectory(w, path, changed);
+        } else if (IsDecafFile(path)) {
+            changed->insert(path);
+        }
+    }
+    return true;
+}
+
+int RunWatch(const char *dirName)
+{
+    WatchState w;
+    if ((w.inotifyFd = inotify_init1(IN_CLOEXEC)) < 0) {
+        fprintf(stderr, "dcc: cannot start watching: %s\n", strerror(errno));
+        return 2;
+    }
+    w.scanner = NewScanner();
+
+    std::string root = dirName;
+    while (root.size() > 1 && root[root.size() - 1] == '/')
+        root.erase(root.size() - 1);
+    std::set<std::string> changed;
+    AddDirectory(&w, root, &changed);
+    if (w.dirs.empty()) return 2;
+
+    while (true) {
+        for (std::set<std::string>::iterator i = changed.begin(); i != changed.end(); ++i)
+            Recheck(&w, *i);
+        changed.clear();
+        PrintDebug("watch", "Watching %d files", (int)w.files.size());
+
+        bool ok = ReadEvents(&w, &changed);
+        pollfd pfd = { w.inotifyFd, POLLIN, 0 };
+        while (ok && poll(&pfd, 1, SettleMillis) > 0)
+            ok = ReadEvents(&w, &changed);
+        if (!ok) break;
+    }
+    fprintf(stderr, "dcc: lost track of '%s': %s\n", dirName, strerror(errno));
+    FreeScanner(w.scanner);
+    close(w.inotifyFd);
+    return 2;
+}
@@ -0,0 +1,25 @@
+/* File: watch.h
+ * -------------
+ * Watch mode checks every Decaf file under a directory once and then
+ * stays running, using Linux inotify to hear about files that are
+ * written, created, renamed or removed. Only those files are checked
+ * again, and only when their contents actually changed. Only the source
+ * and diagnostics of each file are kept in memory between checks; its
+ * tree is not, and is freed with its compilation as soon as the check
+ * is done. Each check prints the file's diagnostics followed by the
+ * usual status line, so the output reads like a batch run that keeps
+ * growing.
+ */
+
+#ifndef _H_watch
+#define _H_watch
+
+
+/* Function: RunWatch
+ * ------------------
+ * Watches dir and its subdirectories until interrupted. Returns the exit
+ * status for main if watching cannot start or stops working.
+ */
+int RunWatch(const char *dir);
+
+#endif